@@ -10,6 +10,7 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET = LifeGame
 TEMPLATE = app
+CONFIG += c++11 thread
 
 # The following define makes your compiler emit warnings if you use
 # any feature of Qt which as been marked as deprecated (the exact warnings
@@ -27,12 +28,20 @@ SOURCES += \
         main.cpp \
         player.cpp \
     screen.cpp \
-    board.cpp
+    renderer.cpp \
+    frame.cpp \
+    simulator.cpp \
+    sparkline.cpp
 
 HEADERS += \
         player.h \
     screen.h \
-    board.h
+    renderer.h \
+    frame.h \
+    simulator.h \
+    sparkline.h
+
+include(engine.pri)
 
 RESOURCES += \
     resource.qrc
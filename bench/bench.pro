@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Benchmarks of the evolve, history and render paths,
+# results are written as CSV or JSON
+#
+#-------------------------------------------------
+
+QT       += core gui widgets
+
+TARGET = bench
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+SOURCES += \
+        main.cpp \
+    harness.cpp \
+    ../screen.cpp \
+    ../renderer.cpp \
+    ../frame.cpp
+
+HEADERS += \
+    harness.h \
+    ../screen.h \
+    ../renderer.h \
+    ../frame.h
+
+include(../engine.pri)
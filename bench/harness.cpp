@@ -0,0 +1,95 @@
+#include "harness.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+void Harness::add(const std::string &name, int iterations, double items,
+                  std::function<void()> setup, std::function<void()> body)
+{
+    Case c = {name, iterations, items, setup, body};
+    cases.push_back(c);
+}
+
+// runs every case whose name contains filter, returns how many ran
+int Harness::run(const std::string &filter, int repetitions, bool list)
+{
+    int ran = 0;
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const Case &c = cases[i];
+        if (c.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        ran += 1;
+        if (list) {
+            printf("%s\n", c.name.c_str());
+            continue;
+        }
+        std::vector<double> times;
+        for (int r = 0; r < repetitions; ++r) {
+            if (c.setup) {
+                c.setup();
+            }
+            auto start = std::chrono::steady_clock::now();
+            c.body();
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            times.push_back(elapsed.count() / c.iterations);
+        }
+        std::sort(times.begin(), times.end());
+        double sum = 0;
+        for (size_t j = 0; j < times.size(); ++j) {
+            sum += times[j];
+        }
+        Result result;
+        result.name = c.name;
+        result.iterations = c.iterations;
+        result.repetitions = repetitions;
+        result.min = times.front();
+        result.median = times[times.size() / 2];
+        result.mean = sum / times.size();
+        result.items_per_second = result.median > 0 ? c.items * 1e9 / result.median : 0;
+        results.push_back(result);
+        fprintf(stderr, "%-40s %14.0f ns %14.3g items/s\n", c.name.c_str(), result.median, result.items_per_second);
+    }
+    return ran;
+}
+
+void Harness::write_csv(FILE *out) const
+{
+    fprintf(out, "name,iterations,repetitions,min_ns,median_ns,mean_ns,items_per_second\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        fprintf(out, "%s,%d,%d,%.1f,%.1f,%.1f,%.6g\n", r.name.c_str(), r.iterations, r.repetitions,
+                r.min, r.median, r.mean, r.items_per_second);
+    }
+}
+
+void Harness::write_json(FILE *out) const
+{
+    char date[64];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(out, "{\n  \"context\": {\n");
+    fprintf(out, "    \"date\": \"%s\",\n", date);
+    fprintf(out, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    fprintf(out, "    \"library_build_type\": \"release\"\n");
+#else
+    fprintf(out, "    \"library_build_type\": \"debug\"\n");
+#endif
+    fprintf(out, "  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"name\": \"%s\",\n", r.name.c_str());
+        fprintf(out, "      \"iterations\": %d,\n", r.iterations);
+        fprintf(out, "      \"repetitions\": %d,\n", r.repetitions);
+        fprintf(out, "      \"real_time\": %.1f,\n", r.median);
+        fprintf(out, "      \"min_time\": %.1f,\n", r.min);
+        fprintf(out, "      \"mean_time\": %.1f,\n", r.mean);
+        fprintf(out, "      \"time_unit\": \"ns\",\n");
+        fprintf(out, "      \"items_per_second\": %.6g\n", r.items_per_second);
+        fprintf(out, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
@@ -0,0 +1,41 @@
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A small benchmark registry in the spirit of Google Benchmark.
+// Every case is set up, then its body is timed once per repetition; the
+// body does a fixed amount of work so runs of different builds compare.
+class Harness
+{
+public:
+    struct Case {
+        std::string name;
+        int iterations; // how many operations one run of the body performs
+        double items; // cells or other units processed per operation
+        std::function<void()> setup;
+        std::function<void()> body;
+    };
+    struct Result {
+        std::string name;
+        int iterations, repetitions;
+        double min, median, mean; // nanoseconds per operation
+        double items_per_second;
+    };
+
+private:
+    std::vector<Case> cases;
+    std::vector<Result> results;
+
+public:
+    void add(const std::string &name, int iterations, double items,
+             std::function<void()> setup, std::function<void()> body);
+    int run(const std::string &filter, int repetitions, bool list);
+    void write_csv(FILE *out) const;
+    void write_json(FILE *out) const;
+};
+
+#endif // HARNESS_H
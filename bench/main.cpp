@@ -0,0 +1,255 @@
+#include <QApplication>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include "harness.h"
+#include "board.h"
+#include "frame.h"
+#include "screen.h"
+#include "simd.h"
+
+static std::unique_ptr<Board> board;
+static std::unique_ptr<Screen> screen;
+static Frame frames[2];
+
+// a fresh board of the given size with about density of its cells alive
+static void fill(int size, double density, unsigned seed, int threads)
+{
+    if (!board || board->Width() != size) {
+        board.reset(new Board(size, size));
+    }
+    board->set_threads(threads);
+    board->set_rule(Rule());
+    board->set_boundary(Board::DEAD_BORDER);
+    board->randomize(seed, density);
+}
+
+static void add_evolve(Harness &harness)
+{
+    int sizes[] = {256, 1024, 4096};
+    int densities[] = {10, 35, 50};
+    for (int size : sizes) {
+        for (int density : densities) {
+            int generations = size >= 4096 ? 16 : 64;
+            harness.add("evolve/" + std::to_string(size) + "/" + std::to_string(density), generations, (double)size * size,
+                        [=]() { fill(size, density / 100.0, 1, 1); },
+                        [=]() {
+                            for (int g = 0; g < generations; ++g) {
+                                board->evolve();
+                            }
+                        });
+        }
+    }
+    // the kernels written out for common rules and the table for the rest
+    const char *rules[] = {"B36/S23", "B3678/S34678", "B2/S", "B34/S34"};
+    for (const char *name : rules) {
+        Rule rule;
+        Rule::parse(name, rule);
+        std::string label = rule.name();
+        label.replace(label.find('/'), 1, "_");
+        harness.add("evolve_rule/1024/" + label, 64, 1024.0 * 1024,
+                    [=]() {
+                        fill(1024, 0.35, 1, 1);
+                        board->set_rule(rule);
+                    },
+                    []() {
+                        for (int g = 0; g < 64; ++g) {
+                            board->evolve();
+                        }
+                    });
+    }
+    const char *boundaries[] = {"dead", "torus", "mirror"};
+    for (int b = 0; b < 3; ++b) {
+        harness.add(std::string("evolve_boundary/1024/") + boundaries[b], 64, 1024.0 * 1024,
+                    [=]() {
+                        fill(1024, 0.35, 1, 1);
+                        board->set_boundary((Board::BOUNDARY)b);
+                    },
+                    []() {
+                        for (int g = 0; g < 64; ++g) {
+                            board->evolve();
+                        }
+                    });
+    }
+    int max_threads = std::max((int)std::thread::hardware_concurrency(), 1);
+    for (int threads = 2; threads <= max_threads; threads *= 2) {
+        harness.add("evolve_threads/4096/" + std::to_string(threads), 16, 4096.0 * 4096,
+                    [=]() { fill(4096, 0.35, 1, threads); },
+                    []() {
+                        for (int g = 0; g < 16; ++g) {
+                            board->evolve();
+                        }
+                    });
+    }
+    // the same generations in one call, temporally blocked
+    for (int size : sizes) {
+        int generations = size >= 4096 ? 16 : 64;
+        harness.add("evolve_batch/" + std::to_string(size) + "/35", generations, (double)size * size,
+                    [=]() { fill(size, 0.35, 1, 1); },
+                    [=]() { board->evolve(generations); });
+    }
+    // each instruction set this CPU has, on one thread
+    for (int level = Simd::SCALAR; level <= Simd::Supported(); ++level) {
+        harness.add(std::string("evolve_simd/1024/") + Simd::name(level), 64, 1024.0 * 1024,
+                    [=]() { fill(1024, 0.35, 1, 1); },
+                    [=]() {
+                        Simd::set_level(level);
+                        for (int g = 0; g < 64; ++g) {
+                            board->evolve();
+                        }
+                        Simd::set_level(Simd::Supported());
+                    });
+    }
+}
+
+static void add_history(Harness &harness)
+{
+    int sizes[] = {256, 1024};
+    for (int size : sizes) {
+        // undo and redo over a history that is already recorded
+        harness.add("decline/" + std::to_string(size), 64, (double)size * size,
+                    [=]() {
+                        fill(size, 0.35, 2, 1);
+                        for (int g = 0; g < 65; ++g) {
+                            board->evolve();
+                        }
+                    },
+                    []() {
+                        for (int g = 0; g < 64; ++g) {
+                            board->decline();
+                        }
+                    });
+        harness.add("redo/" + std::to_string(size), 64, (double)size * size,
+                    [=]() {
+                        fill(size, 0.35, 2, 1);
+                        for (int g = 0; g < 65; ++g) {
+                            board->evolve();
+                        }
+                        for (int g = 0; g < 64; ++g) {
+                            board->decline();
+                        }
+                    },
+                    []() {
+                        for (int g = 0; g < 64; ++g) {
+                            board->evolve();
+                        }
+                    });
+    }
+    harness.add("cell_amount/1024", 1000000, 1,
+                []() { fill(1024, 0.35, 3, 1); },
+                []() {
+                    volatile int sink = 0;
+                    for (int i = 0; i < 1000000; ++i) {
+                        sink = board->cell_amount();
+                    }
+                    (void)sink;
+                });
+}
+
+// Screen::update() on two alternating generations, drawn offscreen
+static void add_render(Harness &harness)
+{
+    struct View {
+        const char *name;
+        int size;
+        double scale;
+    };
+    View views[] = {{"render/cells/1024/1.0", 1024, 1.0},
+                    {"render/cells/1024/0.05", 1024, 0.05},
+                    {"render/blocks/4096/0.005", 4096, 0.005}};
+    for (const View &view : views) {
+        harness.add(view.name, 32, 1280.0 * 800,
+                    [=]() {
+                        fill(view.size, 0.35, 4, 1);
+                        screen.reset(new Screen());
+                        screen->setSize(QSize(1280, 800));
+                        screen->setScale(view.scale, QPoint(0, 0));
+                        // the frames hold what the view shows, as the simulator captures them
+                        qint64 top, left;
+                        int rows, columns;
+                        screen->visibleCells(top, left, rows, columns);
+                        board->evolve();
+                        frames[0].capture(board.get(), 0, top, left, columns, rows, screen->visibleLevel());
+                        board->evolve();
+                        frames[1].capture(board.get(), 1, top, left, columns, rows, screen->visibleLevel());
+                        screen->setFrame(&frames[0]);
+                    },
+                    []() {
+                        for (int i = 0; i < 32; ++i) {
+                            screen->setFrame(&frames[i % 2]);
+                            screen->update();
+                        }
+                    });
+    }
+}
+
+// usage: bench [--filter TEXT] [--repetitions N] [--format csv|json] [--out FILE] [--list]
+int main(int argc, char *argv[])
+{
+    // the render cases need no display
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication a(argc, argv);
+
+    std::string filter, format = "csv";
+    int repetitions = 5;
+    const char *path = nullptr;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : "";
+        if (!strcmp(argv[i], "--filter")) {
+            filter = value;
+            i += 1;
+        } else if (!strcmp(argv[i], "--repetitions")) {
+            repetitions = atoi(value);
+            i += 1;
+        } else if (!strcmp(argv[i], "--format")) {
+            format = value;
+            i += 1;
+        } else if (!strcmp(argv[i], "--out")) {
+            path = value;
+            i += 1;
+        } else if (!strcmp(argv[i], "--list")) {
+            list = true;
+        } else {
+            repetitions = 0;
+            break;
+        }
+    }
+    if (repetitions < 1 || (format != "csv" && format != "json")) {
+        fprintf(stderr, "usage: %s [--filter TEXT] [--repetitions N] [--format csv|json] [--out FILE] [--list]\n", argv[0]);
+        return 1;
+    }
+
+    Harness harness;
+    add_evolve(harness);
+    add_history(harness);
+    add_render(harness);
+    if (!harness.run(filter, repetitions, list)) {
+        fprintf(stderr, "%s: no benchmark matches \"%s\"\n", argv[0], filter.c_str());
+        return 1;
+    }
+    if (list) {
+        return 0;
+    }
+
+    FILE *out = path ? fopen(path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "%s: cannot write %s\n", argv[0], path);
+        return 1;
+    }
+    if (format == "json") {
+        harness.write_json(out);
+    } else {
+        harness.write_csv(out);
+    }
+    if (path) {
+        fclose(out);
+    }
+    screen.reset();
+    return 0;
+}
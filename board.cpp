@@ -1,10 +1,26 @@
 #include "board.h"
-#include <qglobal.h>
+#include "kernel.h"
+#include "prng.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstring>
 
 Board::Board(int w, int h)
-    : width(w), height(h)
+    : width(0), height(0), seed(0), boundary(DEAD_BORDER), pool(nullptr)
 {
-    initialize();
+    // out-of-range sizes are clamped, use resize() to have them rejected
+    resize(std::min(std::max(w, 1), MAX_WIDTH), std::min(std::max(h, 1), MAX_HEIGHT));
+    set_threads(1);
+}
+
+Board::~Board()
+{
+    delete pool;
+}
+
+int Board::is_legal_size(int w, int h)
+{
+    return 0 < w && w <= MAX_WIDTH && 0 < h && h <= MAX_HEIGHT;
 }
 
 int Board::Rounds()
@@ -27,80 +43,660 @@ unsigned Board::Seed()
     return seed;
 }
 
+int Board::Threads()
+{
+    return pool->Threads();
+}
+
+int Board::set_threads(int n)
+{
+    if (n < 1) {
+        return RET_ERROR;
+    }
+    if (!pool || pool->Threads() != n) {
+        delete pool;
+        pool = new WorkerPool(n);
+        bands.assign(n, Band());
+    }
+    return RET_OK;
+}
+
+Rule Board::ActiveRule()
+{
+    return rule;
+}
+
+// the generations already undone no longer follow from the current one
+int Board::set_rule(const Rule &r)
+{
+    if (r != rule) {
+        rule = r;
+        history.truncate();
+        cycles.clear();
+        all_changed = true;
+    }
+    return RET_OK;
+}
+
+Board::BOUNDARY Board::Boundary()
+{
+    return (BOUNDARY)boundary;
+}
+
+int Board::set_boundary(BOUNDARY b)
+{
+    if (b != DEAD_BORDER && b != TORUS && b != MIRROR) {
+        return RET_ERROR;
+    }
+    if (b != boundary) {
+        boundary = b;
+        history.truncate();
+        cycles.clear();
+        all_changed = true;
+    }
+    return RET_OK;
+}
+
 int Board::initialize()
 {
-    newest_index = olddest_index = cur_index = 0;
+    history.clear();
+    cycles.clear();
+    has_previous = false;
     new_borns = new_deads = 0;
+    population = 0;
+    digest = 0;
     rounds = 0;
+    all_changed = true;
+    dense_changes = false;
+    blocks.touch_all();
     return RET_OK;
 }
 
-int Board::set_forward(int &index)
+int Board::resize(int w, int h)
 {
-    index = (index + 1) % MAX_HISTORY;
+    if (!is_legal_size(w, h)) {
+        return RET_ERROR;
+    }
+    width = w;
+    height = h;
+    current.resize(w, h);
+    previous.resize(w, h);
+    size_t tiles = (size_t)(h + TILE_SIZE - 1) / TILE_SIZE * current.Words();
+    changed.assign(tiles, 0);
+    next_changed.assign(tiles, 0);
+    blocks.resize(w, h);
+    initialize();
     return RET_OK;
 }
 
-int Board::set_backward(int &index)
+int Board::set_history_budget(size_t bytes)
 {
-    index = (index - 1 + MAX_HISTORY) % MAX_HISTORY;
+    history.set_budget(bytes);
     return RET_OK;
 }
 
-int Board::next_index(int index)
+size_t Board::history_bytes()
 {
-    return (index + 1) % MAX_HISTORY;
+    return history.Bytes();
 }
 
-int Board::prev_index(int index)
+// how many steps decline() can still go back, a batch being one
+int Board::history_depth()
 {
-    return (index - 1 + MAX_HISTORY) % MAX_HISTORY;
+    return std::max(history.Behind() - 1, 0);
 }
 
-int Board::is_legal(int index)
+int Board::evolve()
 {
-    int ret = 0;
-    if (0 <= index && index < MAX_HISTORY) {
-        int d0 = newest_index - olddest_index;
-        int d1 = index - olddest_index;
-        if (d0 < 0) {
-            ret = (d1 >= 0 || d1 <= d0);
+    // the generation evolved from is where a cycle may begin
+    if (cycles.Last() != rounds) {
+        cycles.observe(rounds, digest);
+    }
+    rounds += 1;
+    if (history.Ahead() > 0) {
+        // replay a generation that was undone, previous is g - 1 and
+        // becomes g + 1 by applying both deltas
+        const History::Delta &next = history.after();
+        if (has_previous && history.Behind() > 0) {
+            History::apply(previous, history.before(1));
         } else {
-            ret = (d1 >= 0 && d1 <= d0);
+            previous = current;
         }
+        digest += delta_digest(previous, next);
+        population += History::apply(previous, next);
+        rounds += next.generations - 1;
+        current.swap(previous);
+        has_previous = true;
+        new_borns = next.borns;
+        new_deads = next.deads;
+        mark_changes(next);
+        mark_blocks(next);
+        history.forward();
+        cycles.observe(rounds, digest);
+        return RET_OK;
     }
-    return ret;
+
+    // the new generation is written over the previous one
+    if (boundary != DEAD_BORDER) {
+        fill_halo();
+    }
+    // A busy board changes most of its words every generation. Its delta
+    // is written by the bands straight into a dense frame laid out like the
+    // grid, next to the rows being evolved, instead of going through word
+    // lists merged afterwards: past the size of the cache that merge cost
+    // more than the generation itself. A delta the budget cannot hold is
+    // not recorded at all, pushing it would only drop the whole history.
+    History::Delta &delta = history.recycle();
+    size_t words = (size_t)height * current.Words();
+    bool keep = history.Budget() > 0 && !(dense_changes && words * sizeof(uint64_t) > history.Budget());
+    uint64_t *frame = nullptr;
+    if (keep && dense_changes) {
+        delta.bits.assign(words, 0);
+        frame = delta.bits.data();
+    }
+    for (Band &band : bands) {
+        band.keep = keep;
+        band.frame = frame;
+    }
+    int tile_rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+    int count = 1;
+    if (pool->Threads() > 1 && (long long)height * current.Words() >= PARALLEL_MIN_WORDS) {
+        // one horizontal band of tiles per worker, results are merged afterwards
+        count = pool->Threads();
+        pool->run([this, count, tile_rows](int id) {
+            evolve_band(tile_rows * id / count, tile_rows * (id + 1) / count, bands[id]);
+        });
+    } else {
+        evolve_band(0, tile_rows, bands[0]);
+    }
+
+    size_t changes = 0;
+    new_borns = new_deads = 0;
+    for (int i = 0; i < count; ++i) {
+        changes += bands[i].changes;
+        new_borns += bands[i].borns;
+        new_deads += bands[i].deads;
+        digest += bands[i].digest;
+    }
+    dense_changes = changes * (sizeof(uint32_t) + sizeof(uint64_t)) >= words * sizeof(uint64_t);
+    delta.dense = dense_changes;
+    if (!keep) {
+        history.clear();
+    } else if (frame) {
+        if (!delta.dense) {
+            // fewer changes than expected, the frame becomes a word list
+            for (size_t i = 0; i < words; ++i) {
+                if (delta.bits[i]) {
+                    delta.bits[delta.where.size()] = delta.bits[i];
+                    delta.where.push_back((uint32_t)i);
+                }
+            }
+            delta.bits.resize(delta.where.size());
+        }
+    } else if (delta.dense) {
+        delta.bits.assign(words, 0);
+        for (int i = 0; i < count; ++i) {
+            Band &band = bands[i];
+            for (size_t j = 0; j < band.where.size(); ++j) {
+                delta.bits[band.where[j]] = band.bits[j];
+            }
+        }
+    } else {
+        delta.where.reserve(changes);
+        delta.bits.reserve(changes);
+        for (int i = 0; i < count; ++i) {
+            Band &band = bands[i];
+            delta.where.insert(delta.where.end(), band.where.begin(), band.where.end());
+            delta.bits.insert(delta.bits.end(), band.bits.begin(), band.bits.end());
+        }
+    }
+    if (keep) {
+        delta.borns = new_borns;
+        delta.deads = new_deads;
+        history.push(delta);
+    }
+    population += new_borns - new_deads;
+
+    if (boundary != DEAD_BORDER) {
+        clear_halo(current);
+    }
+    current.swap(previous);
+    has_previous = true;
+    changed.swap(next_changed);
+    all_changed = false;
+    blocks.touch(changed);
+    cycles.observe(rounds, digest);
+    return RET_OK;
 }
 
-int Board::evolve()
+// the rule is looked up once per band, the kernel is compiled into the loop
+void Board::evolve_band(int begin, int end, Band &band)
 {
-    rounds += 1;
-    new_borns = 0;
-    new_deads = 0;
-    if (cur_index == newest_index) {
-        set_forward(newest_index);
-        if (olddest_index == newest_index) {
-            set_forward(olddest_index);
+    switch (rule.kernel()) {
+    case Rule::CONWAY:
+        evolve_tiles(begin, end, band, ConwayKernel());
+        break;
+    case Rule::HIGHLIFE:
+        evolve_tiles(begin, end, band, HighLifeKernel());
+        break;
+    case Rule::DAY_AND_NIGHT:
+        evolve_tiles(begin, end, band, DayAndNightKernel());
+        break;
+    case Rule::SEEDS:
+        evolve_tiles(begin, end, band, SeedsKernel());
+        break;
+    default: {
+        TableKernel table = {rule.born, rule.survive};
+        evolve_tiles(begin, end, band, table);
+        break;
+    }
+    }
+}
+
+// A tile is TILE_SIZE rows of one word. Only tiles that changed in the
+// last generation, or touch one that did, can change in this one. The
+// others are equal in the current and the previous grid, so they are
+// already right in the output and cost nothing at all.
+template <class Kernel>
+void Board::evolve_tiles(int begin, int end, Band &band, const Kernel &kernel)
+{
+    // 64 cells per word: neighbours are summed with bitwise adders over the
+    // shifted rows above, below and around each word, and evolve_run takes
+    // 4 or 8 words at a time on spans of active words
+    const BitGrid &grid = current;
+    int borns = 0, deads = 0;
+    uint64_t sum = 0;
+    size_t changes = 0;
+    band.where.clear();
+    band.bits.clear();
+    int words = grid.Words();
+    uint64_t tail = grid.tail_mask();
+    std::vector<unsigned char> column(words + 2), active(words);
+    std::vector<int> runs; // start and length of each span of active words
+    std::vector<uint64_t> out(words);
+    for (int t = begin; t < end; ++t) {
+        unsigned char *flags = &next_changed[(size_t)t * words];
+        // a tile is active if any of its eight neighbours or itself changed
+        for (int w = 0; w < words; ++w) {
+            column[w + 1] = tile_changed(t - 1, w) | tile_changed(t, w) | tile_changed(t + 1, w);
         }
-        for (int r = 0; r < height; ++r) {
-            for (int c = 0; c < width; ++c) {
-                CELL_STATE state = single_evolve(r, c);
-                new_borns += (state == NEW_BORN);
-                new_deads += (state == NEW_DEAD);
-                data[newest_index][r][c] = ((state == STILL_ALIVE) || (state == NEW_BORN));
+        if (boundary == TORUS) {
+            // the tiles at either edge are neighbours across it
+            column[0] = column[words];
+            column[words + 1] = column[1];
+        }
+        for (int w = 0; w < words; ++w) {
+            active[w] = all_changed || column[w] || column[w + 1] || column[w + 2];
+            flags[w] = 0;
+        }
+        runs.clear();
+        for (int w = 0; w < words; ++w) {
+            if (active[w] && (w == 0 || !active[w - 1])) {
+                runs.push_back(w);
+                runs.push_back(0);
+            }
+            if (active[w]) {
+                runs.back() += 1;
             }
         }
-    } else {
+        if (runs.empty()) {
+            continue;
+        }
+        int last = std::min(height, (t + 1) * TILE_SIZE);
+        for (int r = t * TILE_SIZE; r < last; ++r) {
+            const uint64_t *up = grid.row(r - 1);
+            const uint64_t *mid = grid.row(r);
+            const uint64_t *down = grid.row(r + 1);
+            uint64_t *dst = previous.row(r);
+            for (size_t i = 0; i < runs.size(); i += 2) {
+                int w = runs[i];
+                evolve_run(up + w, mid + w, down + w, &out[w], runs[i + 1], kernel);
+            }
+            for (int w = 0; w < words; ++w) {
+                if (!active[w]) {
+                    continue;
+                }
+                uint64_t next = out[w];
+                uint64_t now = mid[w];
+                if (w == words - 1) {
+                    // past the last column there may be a halo cell
+                    next &= tail;
+                    now &= tail;
+                }
+                uint64_t diff = next ^ now;
+                if (diff) {
+                    borns += popcount64(diff & next);
+                    deads += popcount64(diff & now);
+                    flags[w] = 1;
+                    uint64_t index = (uint64_t)r * words + w;
+                    sum += word_digest(index, next) - word_digest(index, now);
+                    changes += 1;
+                    if (band.frame) {
+                        band.frame[index] = diff;
+                    } else if (band.keep) {
+                        band.where.push_back((uint32_t)index);
+                        band.bits.push_back(diff);
+                    }
+                }
+                dst[w] = next;
+            }
+        }
+    }
+    band.borns = borns;
+    band.deads = deads;
+    band.digest = sum;
+    band.changes = changes;
+}
+
+int Board::tile_changed(int tile_row, int word)
+{
+    int tile_rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+    if (boundary == TORUS) {
+        tile_row = (tile_row + tile_rows) % tile_rows;
+    }
+    if (tile_row < 0 || tile_row >= tile_rows) {
+        return 0;
+    }
+    return changed[(size_t)tile_row * current.Words() + word];
+}
+
+// Advances many generations: all but the last two are computed without
+// deltas, counters or change tracking, several at a time while the rows
+// are still in cache, and go into the history as a single entry. Undo
+// steps back through the last two generations one at a time, then over
+// the rest of the batch at once.
+int Board::evolve(int generations)
+{
+    if (generations < 0) {
+        return RET_ERROR;
+    }
+    if (generations == 0) {
+        return RET_OK;
+    }
+    if (history.Ahead() > 0) {
+        // undone generations are replayed from their deltas, which is cheaper
+        while (generations > 1 && history.Ahead() > 0) {
+            evolve();
+            generations -= 1;
+        }
+    }
+    if (generations > 2) {
+        advance(generations - 2);
+        generations = 2;
+    }
+    for (; generations > 1; --generations) {
+        evolve();
+    }
+    return evolve();
+}
+
+// Advances in batches of interval generations until stop() returns true
+// or limit generations have passed, stop() sees the board after each
+// batch. Returns the number of generations advanced.
+int Board::run_until(int limit, int interval, const std::function<bool(Board &)> &stop)
+{
+    if (limit < 0 || interval < 1) {
+        return RET_ERROR;
+    }
+    int done = 0;
+    while (done < limit) {
+        int n = std::min(interval, limit - done);
+        evolve(n);
+        done += n;
+        if (stop && stop(*this)) {
+            break;
+        }
+    }
+    return done;
+}
+
+// generations without history, the grid is swapped once per pass
+void Board::advance(int generations)
+{
+    // the entry is the XOR of the grids before and after, built in place;
+    // when the budget cannot hold a full grid the history ends here
+    int words = current.Words();
+    int total = generations;
+    History::Delta *jump = nullptr;
+    if (history.Budget() >= (size_t)height * words * sizeof(uint64_t)) {
+        jump = &history.recycle();
+        jump->dense = true;
+        jump->bits.resize((size_t)height * words);
         for (int r = 0; r < height; ++r) {
-            for (int c = 0; c < width; ++c) {
-                CELL_STATE state = single_evolve(r, c);
-                new_borns += (state == NEW_BORN);
-                new_deads += (state == NEW_DEAD);
+            memcpy(&jump->bits[(size_t)r * words], current.row(r), words * sizeof(uint64_t));
+        }
+    } else {
+        history.clear();
+    }
+    int tile_rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+    while (generations > 0) {
+        // the torus and the mirror need the halo filled for every generation
+        int steps = (boundary == DEAD_BORDER) ? std::min(generations, BLOCK_GENERATIONS) : 1;
+        if (boundary != DEAD_BORDER) {
+            fill_halo();
+        }
+        if (pool->Threads() > 1 && (long long)height * current.Words() >= PARALLEL_MIN_WORDS) {
+            int count = pool->Threads();
+            pool->run([this, count, tile_rows, steps](int id) {
+                advance_band(tile_rows * id / count * TILE_SIZE,
+                             std::min(height, tile_rows * (id + 1) / count * TILE_SIZE), steps);
+            });
+        } else {
+            advance_band(0, height, steps);
+        }
+        if (boundary != DEAD_BORDER) {
+            clear_halo(current);
+        }
+        current.swap(previous);
+        generations -= steps;
+        rounds += steps;
+    }
+    new_borns = new_deads = 0;
+    population = current.count();
+    rehash();
+    all_changed = true;
+    blocks.touch_all();
+    if (!jump) {
+        has_previous = false;
+        return;
+    }
+    // counted against the grid before the batch, which becomes previous
+    for (int r = 0; r < height; ++r) {
+        const uint64_t *now = current.row(r);
+        uint64_t *diff = &jump->bits[(size_t)r * words];
+        for (int w = 0; w < words; ++w) {
+            diff[w] ^= now[w];
+            new_borns += popcount64(diff[w] & now[w]);
+            new_deads += popcount64(diff[w] & ~now[w]);
+        }
+    }
+    jump->borns = new_borns;
+    jump->deads = new_deads;
+    jump->generations = total;
+    history.push(*jump);
+    previous = current;
+    History::apply(previous, history.before(1));
+    has_previous = true;
+}
+
+void Board::advance_band(int begin, int end, int steps)
+{
+    switch (rule.kernel()) {
+    case Rule::CONWAY:
+        advance_rows(begin, end, steps, ConwayKernel());
+        break;
+    case Rule::HIGHLIFE:
+        advance_rows(begin, end, steps, HighLifeKernel());
+        break;
+    case Rule::DAY_AND_NIGHT:
+        advance_rows(begin, end, steps, DayAndNightKernel());
+        break;
+    case Rule::SEEDS:
+        advance_rows(begin, end, steps, SeedsKernel());
+        break;
+    default: {
+        TableKernel table = {rule.born, rule.survive};
+        advance_rows(begin, end, steps, table);
+        break;
+    }
+    }
+}
+
+// Temporal blocking over rows begin to end. The band is swept once from
+// top to bottom; at sweep position s generation k + 1 of row s - k is
+// computed from three rows of generation k, so every intermediate
+// generation needs only a ring of three rows. Rows within steps of the
+// band edges are computed by both neighbouring bands, and rows past the
+// grid stay dead, which is why more than one step needs a dead border.
+template <class Kernel>
+void Board::advance_rows(int begin, int end, int steps, const Kernel &kernel)
+{
+    int words = current.Words();
+    int span = words + 2; // a ring row with its halo words
+    uint64_t tail = current.tail_mask();
+    std::vector<uint64_t> ring((size_t)std::max(steps - 1, 0) * 3 * span, 0);
+    std::vector<uint64_t> zero(span, 0);
+    // row y of generation k, 0 being the current grid
+    auto row = [&](int k, int y) -> const uint64_t * {
+        if (k == 0) {
+            // the halo rows carry the boundary, farther rows are dead
+            return (y >= -1 && y <= height) ? current.row(y) : &zero[1];
+        }
+        if (y < 0 || y >= height) {
+            return &zero[1];
+        }
+        return &ring[((size_t)(k - 1) * 3 + y % 3) * span + 1];
+    };
+    for (int s = begin - (steps - 1); s < end + steps - 1; ++s) {
+        for (int k = 1; k <= steps; ++k) {
+            int y = s - (k - 1);
+            // generation k is needed steps - k rows beyond the band
+            if (y < begin - (steps - k) || y >= end + (steps - k) || y < 0 || y >= height) {
+                continue;
             }
+            const uint64_t *up = row(k - 1, y - 1);
+            const uint64_t *mid = row(k - 1, y);
+            const uint64_t *down = row(k - 1, y + 1);
+            uint64_t *dst = (k == steps) ? previous.row(y) : &ring[((size_t)(k - 1) * 3 + y % 3) * span + 1];
+            evolve_run(up, mid, down, dst, words, kernel);
+            dst[words - 1] &= tail;
         }
     }
-    set_forward(cur_index);
-    return RET_OK;
+}
+
+// For the torus and the mirror the halo around current holds the cells
+// across each edge while a generation is computed, so the kernel reads
+// them like any other cell. Column -1 is bit 63 of word -1, column width is
+// the first bit past the last column, inside the last word or after it.
+void Board::fill_halo()
+{
+    int words = current.Words();
+    int last = (width - 1) % 64, edge = width % 64;
+    bool torus = (boundary == TORUS);
+    for (int r = 0; r < height; ++r) {
+        uint64_t *row = current.row(r);
+        uint64_t first = row[0] & 1, end = (row[words - 1] >> last) & 1;
+        row[-1] = (torus ? end : first) << 63;
+        if (edge) {
+            row[words - 1] |= (torus ? first : end) << edge;
+        } else {
+            row[words] = torus ? first : end;
+        }
+    }
+    // whole rows with their halo words, so the corners come along
+    size_t bytes = (words + 2) * sizeof(uint64_t);
+    memcpy(current.row(-1) - 1, current.row(torus ? height - 1 : 0) - 1, bytes);
+    memcpy(current.row(height) - 1, current.row(torus ? 0 : height - 1) - 1, bytes);
+}
+
+void Board::clear_halo(BitGrid &grid)
+{
+    int words = grid.Words();
+    uint64_t tail = grid.tail_mask();
+    for (int r = 0; r < height; ++r) {
+        uint64_t *row = grid.row(r);
+        row[-1] = 0;
+        row[words - 1] &= tail;
+        row[words] = 0;
+    }
+    memset(grid.row(-1) - 1, 0, (words + 2) * sizeof(uint64_t));
+    memset(grid.row(height) - 1, 0, (words + 2) * sizeof(uint64_t));
+}
+
+// the tiles a delta touches are the ones that changed into the current generation
+void Board::mark_changes(const History::Delta &d)
+{
+    if (d.dense) {
+        all_changed = true;
+        return;
+    }
+    int words = current.Words();
+    std::fill(changed.begin(), changed.end(), 0);
+    for (size_t i = 0; i < d.where.size(); ++i) {
+        uint32_t r = d.where[i] / words, w = d.where[i] % words;
+        changed[(size_t)(r / TILE_SIZE) * words + w] = 1;
+    }
+    all_changed = false;
+}
+
+// what applying d to grid adds to its digest, taken before it is applied
+uint64_t Board::delta_digest(const BitGrid &grid, const History::Delta &d)
+{
+    int words = grid.Words();
+    uint64_t sum = 0;
+    if (d.dense) {
+        for (size_t i = 0; i < d.bits.size(); ++i) {
+            if (d.bits[i]) {
+                uint64_t old = grid.row((int)(i / words))[i % words];
+                sum += word_digest(i, old ^ d.bits[i]) - word_digest(i, old);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < d.where.size(); ++i) {
+            uint64_t old = grid.row((int)(d.where[i] / words))[d.where[i] % words];
+            sum += word_digest(d.where[i], old ^ d.bits[i]) - word_digest(d.where[i], old);
+        }
+    }
+    return sum;
+}
+
+void Board::rehash()
+{
+    int words = current.Words();
+    digest = 0;
+    for (int r = 0; r < height; ++r) {
+        const uint64_t *row = current.row(r);
+        for (int w = 0; w < words; ++w) {
+            digest += word_digest((uint64_t)r * words + w, row[w]);
+        }
+    }
+}
+
+void Board::mark_blocks(const History::Delta &d)
+{
+    if (d.dense) {
+        blocks.touch_all();
+        return;
+    }
+    int words = current.Words();
+    for (size_t i = 0; i < d.where.size(); ++i) {
+        blocks.touch(d.where[i] / words / TILE_SIZE, d.where[i] % words);
+    }
+}
+
+// a cell seen through the boundary, row and column are at most one step
+// outside; past a dead border the zero halo around the grid is read
+inline int Board::neighbour(int row, int column)
+{
+    if (boundary == TORUS) {
+        row = (row + height) % height;
+        column = (column + width) % width;
+    } else if (boundary == MIRROR) {
+        row = std::min(std::max(row, 0), height - 1);
+        column = std::min(std::max(column, 0), width - 1);
+    }
+    int c = column + 64;
+    return (current.row(row)[c / 64 - 1] >> (c % 64)) & 1;
 }
 
 inline Board::CELL_STATE Board::single_evolve(int row, int column)
@@ -109,33 +705,22 @@ inline Board::CELL_STATE Board::single_evolve(int row, int column)
     int dirs[8][2] {{-1, -1},{-1, 0},{-1, 1},{0, -1},{0, 1},{1, -1},{1, 0},{1, 1}};
     int count = 0;
     for (int i = 0; i < 8; ++i) {
-        int r = row + dirs[i][0];
-        int c = column + dirs[i][1];
-        if (0 <= r && r < height && 0 <= c && c < width && data[cur_index][r][c]) {
-            count += 1;
-        }
+        count += neighbour(row + dirs[i][0], column + dirs[i][1]);
     }
-    if (data[cur_index][row][column]) {
-        if (count < 2 || 3 < count) {
-            ret = NEW_DEAD;
-        } else {
-            ret = STILL_ALIVE;
-        }
+    int alive = current.get(row, column);
+    if (rule.next(alive, count)) {
+        ret = alive ? STILL_ALIVE : NEW_BORN;
     } else {
-        if (count == 3) {
-            ret = NEW_BORN;
-        } else {
-            ret = STILL_NULL;
-        }
+        ret = alive ? NEW_DEAD : STILL_NULL;
     }
     return ret;
 }
 
 Board::CELL_STATE Board::single_state(int row, int column)
 {
-    if (cur_index != olddest_index) {
-        int pre = data[prev_index(cur_index)][row][column];
-        int cur = data[cur_index][row][column];
+    if (has_previous) {
+        int pre = previous.get(row, column);
+        int cur = current.get(row, column);
         if (pre == 0) {
             if (cur == 1) {
                 return NEW_BORN;
@@ -150,7 +735,7 @@ Board::CELL_STATE Board::single_state(int row, int column)
             }
         }
     } else {
-        int cur = data[cur_index][row][column];
+        int cur = current.get(row, column);
         if (cur == 1) {
             return NEW_BORN;
         } else {
@@ -159,20 +744,40 @@ Board::CELL_STATE Board::single_state(int row, int column)
     }
 }
 
+const BitGrid &Board::current_grid()
+{
+    return current;
+}
+
+const BitGrid *Board::previous_grid()
+{
+    return has_previous ? &previous : nullptr;
+}
+
+const Pyramid &Board::pyramid()
+{
+    blocks.update(current);
+    return blocks;
+}
+
 int Board::decline()
 {
-    if (cur_index != olddest_index && prev_index(cur_index) != olddest_index) {
-        new_borns = 0;
-        new_deads = 0;
-        set_backward(cur_index);
-        for (int r = 0; r < height; ++r) {
-            for (int c = 0; c < width; ++c) {
-                CELL_STATE state = single_state(r, c);
-                new_borns += (state == NEW_BORN);
-                new_deads += (state == NEW_DEAD);
-            }
-        }
-        rounds -= 1;
+    if (has_previous && history.Behind() >= 2) {
+        // current is g and becomes g - 2, then the two grids trade places;
+        // a batch is one entry of several generations
+        int undone = history.before(1).generations;
+        mark_blocks(history.before(1));
+        digest += delta_digest(current, history.before(1));
+        population += History::apply(current, history.before(1));
+        History::apply(current, history.before(2));
+        current.swap(previous);
+        history.backward();
+        new_borns = history.before(1).borns;
+        new_deads = history.before(1).deads;
+        mark_changes(history.before(1));
+        rounds -= undone;
+        // a period found only after the generation gone back to is forgotten
+        cycles.rewind(rounds);
         return RET_OK;
     } else {
         return RET_ERROR;
@@ -181,50 +786,110 @@ int Board::decline()
 
 int Board::flip(int row, int column)
 {
-    data[cur_index][row][column] = !data[cur_index][row][column];
+    if (row < 0 || row >= height || column < 0 || column >= width) {
+        return RET_ERROR;
+    }
+    uint64_t index = (uint64_t)row * current.Words() + column / 64;
+    uint64_t old = current.row(row)[column / 64];
+    int alive = !current.get(row, column);
+    current.set(row, column, alive);
+    population += alive ? 1 : -1;
+    digest += word_digest(index, current.row(row)[column / 64]) - word_digest(index, old);
+    // what used to follow is no longer what this board evolves into
+    history.truncate();
+    cycles.clear();
+    history.toggle((uint32_t)((size_t)row * current.Words() + column / 64), (uint64_t)1 << (column % 64));
+    changed[(size_t)(row / TILE_SIZE) * current.Words() + column / 64] = 1;
+    blocks.touch(row / TILE_SIZE, column / 64);
     return RET_OK;
 }
 
 int Board::empty()
 {
     initialize();
-    for (int r = 0; r < height; ++r) {
-        data[cur_index][r].reset();
-    }
+    current.clear();
     return RET_OK;
 }
 
-int Board::randomize(unsigned _seed)
+// Every word depends only on the seed and where it is, so the board is the
+// same for any number of threads and on any machine.
+int Board::randomize(unsigned _seed, double density)
 {
+    if (!(0 <= density && density <= 1)) {
+        return RET_ERROR;
+    }
     seed = _seed;
     initialize();
-    qsrand(seed);
-    for (int r = 0; r < height; ++r) {
-        for (int c = 0; c < width; ++c) {
-            data[cur_index][r][c] = qrand() % 2;
-        }
+    uint32_t d = (uint32_t)(density * (1u << DENSITY_BITS) + 0.5);
+    if (pool->Threads() > 1 && (long long)height * current.Words() >= PARALLEL_MIN_WORDS) {
+        int count = pool->Threads();
+        pool->run([this, count, d](int id) {
+            randomize_rows(height * id / count, height * (id + 1) / count, d);
+        });
+    } else {
+        randomize_rows(0, height, d);
     }
+    population = current.count();
+    rehash();
     return RET_OK;
 }
 
-int Board::cell_amount()
+void Board::randomize_rows(int begin, int end, uint32_t density)
 {
-    return cell_amount(cur_index);
+    uint64_t key = mix64(seed);
+    int words = current.Words();
+    uint64_t tail = current.tail_mask();
+    for (int r = begin; r < end; ++r) {
+        uint64_t *row = current.row(r);
+        for (int w = 0; w < words; ++w) {
+            row[w] = random_cells(key, (uint64_t)r * words + w, density);
+        }
+        row[words - 1] &= tail;
+    }
 }
 
-int Board::cell_amount(int index)
+// starts a new history from a generation computed elsewhere
+int Board::replace(const BitGrid &grid, int _rounds)
 {
-    if (is_legal(index)) {
-        int cnt = 0;
-        for (int r = 0; r < height; ++r) {
-            for (int c = 0; c < width; ++c) {
-                cnt += data[index][r][c];
-            }
-        }
-        return cnt;
-    } else {
+    if (grid.Width() != width || grid.Height() != height) {
+        return RET_ERROR;
+    }
+    initialize();
+    current = grid;
+    population = current.count();
+    rehash();
+    rounds = _rounds;
+    return RET_OK;
+}
+
+// resumes a saved run, the grids are taken over rather than copied and
+// prev may be null; the history starts again from here
+int Board::restore(BitGrid &grid, BitGrid *prev, int _rounds, unsigned _seed, int borns, int deads)
+{
+    if (grid.Width() != width || grid.Height() != height) {
+        return RET_ERROR;
+    }
+    if (prev && (prev->Width() != width || prev->Height() != height)) {
         return RET_ERROR;
     }
+    initialize();
+    current.swap(grid);
+    if (prev) {
+        previous.swap(*prev);
+        has_previous = true;
+    }
+    population = current.count();
+    rehash();
+    rounds = _rounds;
+    seed = _seed;
+    new_borns = borns;
+    new_deads = deads;
+    return RET_OK;
+}
+
+int Board::cell_amount()
+{
+    return population;
 }
 
 int Board::increment()
@@ -236,3 +901,18 @@ int Board::decrement()
 {
     return new_deads;
 }
+
+uint64_t Board::Digest()
+{
+    return digest;
+}
+
+int Board::Period()
+{
+    return cycles.Period();
+}
+
+int Board::PeriodStart()
+{
+    return (int)cycles.Start();
+}
@@ -1,58 +1,136 @@
 #ifndef BOARD_H
 #define BOARD_H
 
-#define MAX_WIDTH 200
-#define MAX_HEIGHT 200
-#define MAX_HISTORY 10
+#define MAX_WIDTH 32768
+#define MAX_HEIGHT 32768
+#define PARALLEL_MIN_WORDS 4096 // smaller boards are not worth waking the pool
+#define TILE_SIZE 64 // rows per tile of change tracking, a tile is one word wide
+#define BLOCK_GENERATIONS 8 // generations per pass when many are advanced at once
 
-#include <bitset>
+#include <functional>
+#include <vector>
+#include "cycle.h"
+#include "grid.h"
+#include "history.h"
+#include "pool.h"
+#include "pyramid.h"
+#include "rule.h"
 
 class Board
 {
 private:
     int width, height;
-    std::bitset<MAX_WIDTH> data[MAX_HISTORY][MAX_HEIGHT];
-    int cur_index, olddest_index, newest_index;
+    BitGrid current, previous;
+    bool has_previous;
+    History history;
     int new_borns, new_deads;
+    int population; // kept up to date by every operation, never rescanned
+    uint64_t digest; // sum of word_digest() over current, kept up to date the same way
+    CycleDetector cycles;
     unsigned seed;
     int rounds;
+    Rule rule;
+    int boundary;
+
+    // what each parallel band found, merged after the generation
+    struct Band {
+        int borns, deads;
+        uint64_t digest;
+        size_t changes; // changed words
+        bool keep; // false when the history would drop the delta anyway
+        uint64_t *frame; // the dense delta written in place, or null for where and bits
+        std::vector<uint32_t> where;
+        std::vector<uint64_t> bits;
+    };
+    WorkerPool *pool;
+    std::vector<Band> bands;
+    bool dense_changes; // the last delta was dense, the next one likely is too
+
+    // tiles whose cells changed in the last generation
+    std::vector<unsigned char> changed, next_changed;
+    bool all_changed;
+
+    // block counts for zoomed out views, brought up to date on demand
+    Pyramid blocks;
+
+    void evolve_band(int begin, int end, Band &band);
+    template <class Kernel>
+    void evolve_tiles(int begin, int end, Band &band, const Kernel &kernel);
+    int tile_changed(int tile_row, int word);
+    void mark_changes(const History::Delta &d);
+    void mark_blocks(const History::Delta &d);
+    uint64_t delta_digest(const BitGrid &grid, const History::Delta &d);
+    void rehash();
+    void advance(int generations);
+    void advance_band(int begin, int end, int steps);
+    template <class Kernel>
+    void advance_rows(int begin, int end, int steps, const Kernel &kernel);
+    void randomize_rows(int begin, int end, uint32_t density);
+    void fill_halo();
+    void clear_halo(BitGrid &grid);
+    int neighbour(int row, int column);
 
 public:
     enum RETURN_VALUE {RET_ERROR = -1, RET_OK};
     enum CELL_STATE {NEW_BORN, NEW_DEAD, STILL_NULL, STILL_ALIVE};
+    // what lies beyond the edges: nothing, the opposite edge, or the edge itself
+    enum BOUNDARY {DEAD_BORDER, TORUS, MIRROR};
 
     Board(int w, int h);
+    ~Board();
+    Board(const Board &) = delete;
+    Board &operator=(const Board &) = delete;
+    static int is_legal_size(int w, int h);
 
     // basic funcs
     int Rounds();
     int Width();
     int Height();
     unsigned Seed();
+    int Threads();
+    int set_threads(int n);
+    Rule ActiveRule();
+    int set_rule(const Rule &r);
+    BOUNDARY Boundary();
+    int set_boundary(BOUNDARY b);
     int initialize();
+    int resize(int w, int h);
     CELL_STATE single_evolve(int row, int column);
     CELL_STATE single_state(int row, int column);
 
-    // index operation
-    int set_forward(int &index);
-    int set_backward(int &index);
-    int next_index(int index);
-    int prev_index(int index);
-    int is_legal(int index);
+    // grid access
+    const BitGrid &current_grid();
+    const BitGrid *previous_grid();
+    const Pyramid &pyramid();
+
+    // history operation
+    int set_history_budget(size_t bytes);
+    size_t history_bytes();
+    int history_depth();
 
     // evolution operation
     int evolve();
+    int evolve(int generations);
+    int run_until(int limit, int interval, const std::function<bool(Board &)> &stop);
     int decline();
 
     // content operation
     int flip(int row, int column);
     int empty();
-    int randomize(unsigned _seed);
+    int randomize(unsigned _seed, double density = 0.5);
+    int replace(const BitGrid &grid, int _rounds);
+    int restore(BitGrid &grid, BitGrid *prev, int _rounds, unsigned _seed, int borns, int deads);
 
     // calculation operation
     int cell_amount();
-    int cell_amount(int index);
     int increment();
     int decrement();
+
+    // cycle detection, the period is 0 until a generation repeats one of
+    // the last CYCLE_WINDOW generations evolved in a row
+    uint64_t Digest();
+    int Period();
+    int PeriodStart();
 };
 
 #endif // BOARD_H
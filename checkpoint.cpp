@@ -0,0 +1,285 @@
+#include "checkpoint.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define CHUNK_WORDS (1 << 17) // words collected before each write, 1 MB
+
+static const char MAGIC[8] = {'L', 'I', 'F', 'E', 'C', 'K', 'P', 'T'};
+
+static void put32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static void put64(unsigned char *p, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint32_t get32(const unsigned char *p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) {
+        v |= (uint32_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+static uint64_t get64(const unsigned char *p)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+// Grid words are stored in host order, which is little-endian on every
+// platform the program is built for.
+class GridWriter
+{
+private:
+    FILE *file;
+    std::vector<uint64_t> buffer;
+    bool ok;
+
+public:
+    explicit GridWriter(FILE *f) : file(f), ok(true) {}
+    void put(const uint64_t *words, size_t n)
+    {
+        if (buffer.size() + n > CHUNK_WORDS) {
+            flush();
+        }
+        if (n > CHUNK_WORDS) {
+            ok = ok && fwrite(words, sizeof(uint64_t), n, file) == n;
+            return;
+        }
+        buffer.insert(buffer.end(), words, words + n);
+    }
+    int flush()
+    {
+        if (!buffer.empty()) {
+            ok = ok && fwrite(buffer.data(), sizeof(uint64_t), buffer.size(), file) == buffer.size();
+            buffer.clear();
+        }
+        return ok ? Board::RET_OK : Board::RET_ERROR;
+    }
+};
+
+// The codec works on the rows laid end to end as one stream of words:
+// blocks of a 32-bit count of empty words, a 32-bit count of literal
+// words and then the literals. Dense boards grow by at most a few bytes.
+static size_t encode(const BitGrid &grid, std::vector<uint64_t> &out)
+{
+    out.clear();
+    int words = grid.Words();
+    uint32_t zeros = 0;
+    size_t block = 0; // where the open block's counts are
+    bool open = false;
+    for (int r = 0; r < grid.Height(); ++r) {
+        const uint64_t *row = grid.row(r);
+        for (int i = 0; i < words; ++i) {
+            if (row[i] == 0) {
+                open = false;
+                zeros += 1;
+                continue;
+            }
+            if (!open || (uint32_t)(out[block] >> 32) == UINT32_MAX) {
+                block = out.size();
+                out.push_back(zeros);
+                zeros = 0;
+                open = true;
+            }
+            out[block] += (uint64_t)1 << 32;
+            out.push_back(row[i]);
+        }
+    }
+    if (zeros) {
+        out.push_back(zeros);
+    }
+    return out.size() * sizeof(uint64_t);
+}
+
+static int decode(const uint64_t *src, size_t n, BitGrid &grid)
+{
+    size_t words = grid.Words(), total = words * grid.Height(), at = 0;
+    const uint64_t *end = src + n;
+    while (src < end) {
+        uint64_t counts = *src++;
+        size_t zeros = (uint32_t)counts, literals = (uint32_t)(counts >> 32);
+        if (zeros > total - at || literals > total - at - zeros || literals > (size_t)(end - src)) {
+            return Board::RET_ERROR;
+        }
+        at += zeros;
+        while (literals) {
+            size_t take = std::min(literals, words - at % words);
+            memcpy(grid.row((int)(at / words)) + at % words, src, take * sizeof(uint64_t));
+            src += take;
+            at += take;
+            literals -= take;
+        }
+    }
+    return Board::RET_OK;
+}
+
+static int write_grid(FILE *file, const BitGrid &grid, bool compress, std::vector<uint64_t> &scratch)
+{
+    unsigned char length[8];
+    size_t words = grid.Words();
+    if (compress) {
+        put64(length, encode(grid, scratch));
+        if (fwrite(length, 1, 8, file) != 8) {
+            return Board::RET_ERROR;
+        }
+        GridWriter out(file);
+        out.put(scratch.data(), scratch.size());
+        return out.flush();
+    }
+    put64(length, words * grid.Height() * sizeof(uint64_t));
+    if (fwrite(length, 1, 8, file) != 8) {
+        return Board::RET_ERROR;
+    }
+    GridWriter out(file);
+    for (int r = 0; r < grid.Height(); ++r) {
+        out.put(grid.row(r), words);
+    }
+    return out.flush();
+}
+
+static int read_grid(const unsigned char *&p, const unsigned char *end, BitGrid &grid, bool compressed)
+{
+    if (end - p < 8) {
+        return Board::RET_ERROR;
+    }
+    uint64_t bytes = get64(p);
+    p += 8;
+    if (bytes % sizeof(uint64_t) || bytes > (uint64_t)(end - p)) {
+        return Board::RET_ERROR;
+    }
+    size_t words = grid.Words();
+    if (compressed) {
+        // the words are aligned unless a later header size is not a multiple of 8
+        if ((uintptr_t)p % alignof(uint64_t)) {
+            std::vector<uint64_t> copy(bytes / sizeof(uint64_t));
+            memcpy(copy.data(), p, bytes);
+            p += bytes;
+            return decode(copy.data(), copy.size(), grid);
+        }
+        int ret = decode((const uint64_t *)p, bytes / sizeof(uint64_t), grid);
+        p += bytes;
+        return ret;
+    }
+    if (bytes != words * grid.Height() * sizeof(uint64_t)) {
+        return Board::RET_ERROR;
+    }
+    for (int r = 0; r < grid.Height(); ++r) {
+        memcpy(grid.row(r), p, words * sizeof(uint64_t));
+        p += words * sizeof(uint64_t);
+    }
+    return Board::RET_OK;
+}
+
+// cells past the right edge must stay dead whatever the file holds
+static void clear_tail(BitGrid &grid)
+{
+    uint64_t tail = grid.tail_mask();
+    for (int r = 0; r < grid.Height(); ++r) {
+        grid.row(r)[grid.Words() - 1] &= tail;
+    }
+}
+
+int Checkpoint::save(Board *board, const char *path, bool compress)
+{
+    const BitGrid *prev = board->previous_grid();
+    unsigned char header[CHECKPOINT_HEADER] = {0};
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    put32(header + 8, CHECKPOINT_VERSION);
+    put32(header + 12, CHECKPOINT_HEADER);
+    put32(header + 16, (prev ? HAS_PREVIOUS : 0) | (compress ? COMPRESSED : 0));
+    put32(header + 20, (uint32_t)board->Width());
+    put32(header + 24, (uint32_t)board->Height());
+    put32(header + 28, (uint32_t)board->Rounds());
+    put32(header + 32, board->Seed());
+    put32(header + 36, (uint32_t)board->increment());
+    put32(header + 40, (uint32_t)board->decrement());
+    put32(header + 44, (uint32_t)board->cell_amount());
+    put32(header + 48, board->ActiveRule().born);
+    put32(header + 52, board->ActiveRule().survive);
+    put32(header + 56, (uint32_t)board->Boundary());
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return Board::RET_ERROR;
+    }
+    std::vector<uint64_t> scratch;
+    int ret = (fwrite(header, 1, sizeof(header), file) == sizeof(header)) ? Board::RET_OK : Board::RET_ERROR;
+    if (ret == Board::RET_OK) {
+        ret = write_grid(file, board->current_grid(), compress, scratch);
+    }
+    if (ret == Board::RET_OK && prev) {
+        ret = write_grid(file, *prev, compress, scratch);
+    }
+    if (fclose(file) != 0) {
+        ret = Board::RET_ERROR;
+    }
+    return ret;
+}
+
+int Checkpoint::load(Board *board, const char *path)
+{
+    MappedFile file;
+    if (file.open(path) != Board::RET_OK || file.Size() < CHECKPOINT_HEADER) {
+        return Board::RET_ERROR;
+    }
+    const unsigned char *p = (const unsigned char *)file.Data();
+    const unsigned char *end = p + file.Size();
+    uint32_t version = get32(p + 8), size = get32(p + 12), flags = get32(p + 16);
+    int width = (int)get32(p + 20), height = (int)get32(p + 24);
+    if (memcmp(p, MAGIC, sizeof(MAGIC)) || version > CHECKPOINT_VERSION || size < CHECKPOINT_HEADER
+        || size > file.Size() || !Board::is_legal_size(width, height)) {
+        return Board::RET_ERROR;
+    }
+    int rounds = (int)get32(p + 28), borns = (int)get32(p + 36), deads = (int)get32(p + 40);
+    unsigned seed = get32(p + 32);
+    int population = (int)get32(p + 44);
+    Rule rule;
+    if (version >= 2) {
+        rule = Rule(get32(p + 48) & 0x1ff, get32(p + 52) & 0x1ff);
+    }
+    uint32_t boundary = (version >= 3) ? get32(p + 56) : (uint32_t)Board::DEAD_BORDER;
+    if (boundary > Board::MIRROR || rounds < 0) {
+        return Board::RET_ERROR;
+    }
+    p += size;
+
+    bool compressed = (flags & COMPRESSED) != 0;
+    BitGrid grid(width, height), prev;
+    if (read_grid(p, end, grid, compressed) != Board::RET_OK) {
+        return Board::RET_ERROR;
+    }
+    clear_tail(grid);
+    if (flags & HAS_PREVIOUS) {
+        prev.resize(width, height);
+        if (read_grid(p, end, prev, compressed) != Board::RET_OK) {
+            return Board::RET_ERROR;
+        }
+        clear_tail(prev);
+    }
+    if (grid.count() != population) {
+        return Board::RET_ERROR;
+    }
+    // every field is known to be valid, only now is the board touched
+    if ((board->Width() != width || board->Height() != height) && board->resize(width, height) != Board::RET_OK) {
+        return Board::RET_ERROR;
+    }
+    board->set_rule(rule);
+    board->set_boundary((Board::BOUNDARY)boundary);
+    return board->restore(grid, (flags & HAS_PREVIOUS) ? &prev : nullptr, rounds, seed, borns, deads);
+}
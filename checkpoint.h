@@ -0,0 +1,24 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#define CHECKPOINT_VERSION 3 // 2 added the rule, 3 the boundary
+#define CHECKPOINT_HEADER 64 // bytes, later versions may only grow it
+
+#include "board.h"
+
+// Binary snapshots of a running board: a fixed header with the counters,
+// then the packed rows of the current and, if there is one, the previous
+// generation. Rows are written verbatim or, when asked for, with a word
+// level run-length codec that removes the empty words of sparse boards.
+// The undo history is not part of a snapshot.
+class Checkpoint
+{
+public:
+    enum FLAG {HAS_PREVIOUS = 1, COMPRESSED = 2};
+
+    static int save(Board *board, const char *path, bool compress);
+    // the board is resized to the snapshot
+    static int load(Board *board, const char *path);
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Headless command line runner
+#
+#-------------------------------------------------
+
+CONFIG   -= qt
+
+TARGET = life
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+win32:CONFIG(release, debug|release): ENGINE_DIR = $$OUT_PWD/../engine/release
+else:win32:CONFIG(debug, debug|release): ENGINE_DIR = $$OUT_PWD/../engine/debug
+else: ENGINE_DIR = $$OUT_PWD/../engine
+
+LIBS += -L$$ENGINE_DIR -lengine
+win32-msvc*: PRE_TARGETDEPS += $$ENGINE_DIR/engine.lib
+else: PRE_TARGETDEPS += $$ENGINE_DIR/libengine.a
+
+SOURCES += \
+        main.cpp
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "board.h"
+#include "pattern.h"
+#include "checkpoint.h"
+#include "ensemble.h"
+#include "simd.h"
+#include "series.h"
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --size WxH         board size, default 1024x1024\n"
+            "  --load FILE        start from an RLE or plain text pattern instead of a seed\n"
+            "  --resume FILE      start from a checkpoint, the board takes its size\n"
+            "  --checkpoint FILE  write a checkpoint of the last run's final state\n"
+            "  --save FILE        write the last run's final generation, .cells or .txt\n"
+            "                     for plain text and RLE otherwise\n"
+            "  --series FILE      write population, births, deaths and step time of each\n"
+            "                     generation of the last run as CSV\n"
+            "  --seed N           first seed, default 1\n"
+            "  --rule RULE        rule in B/S notation, default B3/S23\n"
+            "  --boundary MODE    dead, torus or mirror, default dead\n"
+            "  --density P        chance of a seeded cell being alive, default 0.5\n"
+            "  --runs N           how many seeds to run one after another, default 1\n"
+            "  --generations N    generations per run, default 1000\n"
+            "  --threads N        worker threads, default one per core\n"
+            "  --history BYTES    undo history kept while running, default 0\n"
+            "  --stop-on-cycle    end a run as soon as the board repeats itself\n"
+            "  --ensemble         run the seeds side by side, one board per thread, each\n"
+            "                     until it repeats or reaches the generation limit\n"
+            "  --simd LEVEL       scalar, avx2 or avx512, default the best the CPU has\n"
+            "  --cross-check      compare every vector step with the scalar one, exit\n"
+            "                     with 1 if any differed\n"
+            "prints one CSV line per run, period is 0 when no repeat was seen\n",
+            name);
+}
+
+// exit status of a run, a vector step that differed from the scalar one fails it
+static int cross_checked(const char *name)
+{
+    if (!Simd::CrossCheck()) {
+        return 0;
+    }
+    if (Simd::Mismatches()) {
+        fprintf(stderr, "%s: %s differed from scalar in %lld words\n", name, Simd::name(Simd::Level()),
+                Simd::Mismatches());
+        return 1;
+    }
+    fprintf(stderr, "%s: %s matched scalar\n", name, Simd::name(Simd::Level()));
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int width = 1024, height = 1024;
+    const char *path = nullptr;
+    const char *output = nullptr;
+    const char *resume = nullptr;
+    const char *checkpoint = nullptr;
+    const char *series = nullptr;
+    unsigned seed = 1;
+    double density = 0.5;
+    Rule rule;
+    Board::BOUNDARY boundary = Board::DEAD_BORDER;
+    int runs = 1;
+    int generations = 1000;
+    int threads = std::max((int)std::thread::hardware_concurrency(), 1);
+    size_t history = 0;
+    bool stop = false;
+    bool ensemble = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--stop-on-cycle")) {
+            stop = true;
+            continue;
+        }
+        if (!strcmp(argv[i], "--ensemble")) {
+            ensemble = true;
+            continue;
+        }
+        if (!strcmp(argv[i], "--cross-check")) {
+            Simd::set_cross_check(true);
+            continue;
+        }
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (!strcmp(argv[i], "--size")) {
+            if (sscanf(value, "%dx%d", &width, &height) != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--load")) {
+            path = value;
+        } else if (!strcmp(argv[i], "--resume")) {
+            resume = value;
+        } else if (!strcmp(argv[i], "--checkpoint")) {
+            checkpoint = value;
+        } else if (!strcmp(argv[i], "--save")) {
+            output = value;
+        } else if (!strcmp(argv[i], "--series")) {
+            series = value;
+        } else if (!strcmp(argv[i], "--seed")) {
+            seed = (unsigned)strtoul(value, nullptr, 0);
+        } else if (!strcmp(argv[i], "--rule")) {
+            if (Rule::parse(value, rule) != Board::RET_OK) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--boundary")) {
+            if (!strcmp(value, "dead")) {
+                boundary = Board::DEAD_BORDER;
+            } else if (!strcmp(value, "torus")) {
+                boundary = Board::TORUS;
+            } else if (!strcmp(value, "mirror")) {
+                boundary = Board::MIRROR;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--density")) {
+            density = atof(value);
+        } else if (!strcmp(argv[i], "--runs")) {
+            runs = atoi(value);
+        } else if (!strcmp(argv[i], "--generations")) {
+            generations = atoi(value);
+        } else if (!strcmp(argv[i], "--threads")) {
+            threads = atoi(value);
+        } else if (!strcmp(argv[i], "--history")) {
+            history = (size_t)strtoull(value, nullptr, 0);
+        } else if (!strcmp(argv[i], "--simd")) {
+            int level = Simd::SCALAR;
+            while (level <= Simd::AVX512 && strcmp(value, Simd::name(level))) {
+                level += 1;
+            }
+            if (Simd::set_level(level) != Simd::RET_OK) {
+                fprintf(stderr, "%s: %s is not available, this CPU has %s\n", argv[0], value,
+                        Simd::name(Simd::Supported()));
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+        i += 1;
+    }
+    if (!Board::is_legal_size(width, height) || !(0 <= density && density <= 1) || runs < 1 || generations < 0 || threads < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (ensemble) {
+        // every board stands alone, there is nothing to load or save
+        if (path || resume || checkpoint || output || series) {
+            usage(argv[0]);
+            return 1;
+        }
+        Ensemble runner(width, height);
+        runner.set_threads(threads);
+        runner.set_rule(rule);
+        runner.set_boundary(boundary);
+        runner.set_density(density);
+        runner.set_limit(generations);
+        runner.run(seed, runs);
+        runner.write_csv(stdout);
+        fprintf(stderr, "%d boards in %.3f s, %.1f boards/s on %d threads, %lld stolen\n", runs, runner.Seconds(),
+                runner.boards_per_second(), runner.Threads(), runner.Steals());
+        return cross_checked(argv[0]);
+    }
+
+    Board board(width, height);
+    board.set_threads(threads);
+    board.set_history_budget(history);
+    board.set_rule(rule);
+    board.set_boundary(boundary);
+    // the newest 4M generations of a longer run
+    TimeSeries samples(series ? std::min(std::max(generations, 1), 1 << 22) : 1);
+    printf("seed,width,height,generations,population,ms,generations_per_second,period,period_start\n");
+    for (int run = 0; run < runs; ++run) {
+        unsigned s = seed + (unsigned)run;
+        if (resume) {
+            if (Checkpoint::load(&board, resume) != Board::RET_OK) {
+                fprintf(stderr, "%s: cannot resume from %s\n", argv[0], resume);
+                return 1;
+            }
+        } else if (path) {
+            if (Pattern::load(&board, path) != Board::RET_OK) {
+                fprintf(stderr, "%s: cannot load %s\n", argv[0], path);
+                return 1;
+            }
+        } else {
+            board.randomize(s, density);
+        }
+        auto start = std::chrono::steady_clock::now();
+        int done = 0;
+        if (series && run == runs - 1) {
+            // only the last run is written, only it goes a generation at a time
+            auto last = start;
+            while (done < generations && !(stop && board.Period())) {
+                board.evolve();
+                done += 1;
+                auto now = std::chrono::steady_clock::now();
+                samples.record(board.Rounds(), board.cell_amount(), board.increment(), board.decrement(),
+                               std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+                last = now;
+            }
+        } else if (stop) {
+            // cycles are only seen one generation at a time
+            while (done < generations && !board.Period()) {
+                board.evolve();
+                done += 1;
+            }
+        } else {
+            board.evolve(generations);
+            done = generations;
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        double ms = elapsed.count();
+        printf("%u,%d,%d,%d,%d,%.3f,%.1f,%d,%d\n", path ? 0 : resume ? board.Seed() : s, board.Width(), board.Height(),
+               done, board.cell_amount(), ms, ms > 0 ? done * 1000.0 / ms : 0.0,
+               board.Period(), board.Period() ? board.PeriodStart() : -1);
+        fflush(stdout);
+    }
+    if (checkpoint && Checkpoint::save(&board, checkpoint, true) != Board::RET_OK) {
+        fprintf(stderr, "%s: cannot write %s\n", argv[0], checkpoint);
+        return 1;
+    }
+    if (output && Pattern::save(&board, output, Pattern::format_of(output)) != Board::RET_OK) {
+        fprintf(stderr, "%s: cannot save %s\n", argv[0], output);
+        return 1;
+    }
+    if (series && samples.write_csv(series) != TimeSeries::RET_OK) {
+        fprintf(stderr, "%s: cannot write %s\n", argv[0], series);
+        return 1;
+    }
+    return cross_checked(argv[0]);
+}
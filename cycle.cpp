@@ -0,0 +1,101 @@
+#include "cycle.h"
+
+CycleDetector::CycleDetector()
+    : table(2 * CYCLE_WINDOW), ring(CYCLE_WINDOW)
+{
+    clear();
+}
+
+void CycleDetector::clear()
+{
+    for (Slot &s : table) {
+        s.generation = -1;
+    }
+    first = last = -1;
+    period = 0;
+    start = -1;
+}
+
+// Forgets the generations after the given one, a period is kept only if it
+// was already seen by then. The ring still holds the earlier digests, so
+// evolving on from there finds the same start as before.
+void CycleDetector::rewind(long long generation)
+{
+    if (generation < first || generation <= last - CYCLE_WINDOW) {
+        clear();
+        return;
+    }
+    if (generation < last) {
+        last = generation;
+    }
+    if (period && start + period > last) {
+        period = 0;
+        start = -1;
+    }
+}
+
+// Returns the period once the board has repeated, 0 until then. The first
+// repeat found is the shortest period, its start is then moved back for as
+// long as the ring shows the same period further back.
+int CycleDetector::observe(long long generation, uint64_t digest)
+{
+    if (last >= 0 && generation != last + 1) {
+        // stepping back and evolving again meets the same generations
+        bool replay = generation > first && generation <= last && generation > last - CYCLE_WINDOW &&
+                      ring[generation % CYCLE_WINDOW] == digest;
+        if (!replay) {
+            clear();
+        }
+    }
+    if (first < 0) {
+        first = generation;
+    }
+    last = generation;
+    ring[generation % CYCLE_WINDOW] = digest;
+    if (period) {
+        return period;
+    }
+
+    size_t mask = table.size() - 1;
+    Slot *victim = nullptr;
+    long long oldest = 0;
+    for (int i = 0; i < CYCLE_PROBES; ++i) {
+        Slot &s = table[(digest + i) & mask];
+        // a slot written after a rewind no longer matches the ring
+        bool live = s.generation >= first && s.generation < generation && generation - s.generation < CYCLE_WINDOW &&
+                    ring[s.generation % CYCLE_WINDOW] == s.digest;
+        if (live && s.digest == digest) {
+            period = (int)(generation - s.generation);
+            start = s.generation;
+            while (start - 1 >= first && start - 1 > generation - CYCLE_WINDOW &&
+                   ring[(start - 1) % CYCLE_WINDOW] == ring[(start - 1 + period) % CYCLE_WINDOW]) {
+                start -= 1;
+            }
+            return period;
+        }
+        // an empty or expired slot is taken first, else the oldest one
+        long long age = live ? s.generation : -1;
+        if (!victim || age < oldest) {
+            victim = &s;
+            oldest = age;
+        }
+    }
+    victim->digest = digest;
+    victim->generation = generation;
+    return 0;
+}
+
+long long CycleDetector::Last() const
+{
+    return last;
+}
+
+int CycleDetector::Period() const
+{
+    return period;
+}
+
+long long CycleDetector::Start() const
+{
+    return start;
+}
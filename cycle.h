@@ -0,0 +1,54 @@
+#ifndef CYCLE_H
+#define CYCLE_H
+
+#define CYCLE_WINDOW 1024 // longest period looked for, in generations
+#define CYCLE_PROBES 8 // table slots searched per lookup
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "prng.h"
+
+// Finds the period a board settles into from one 64-bit digest per
+// generation. The digests of the last CYCLE_WINDOW generations are kept in
+// a ring and indexed by a fixed-size open addressing table, so memory stays
+// the same however long a run lasts. Generations are observed one after
+// another; going back and evolving again is recognised, any other gap or a
+// different generation starts over.
+class CycleDetector
+{
+private:
+    struct Slot {
+        uint64_t digest;
+        long long generation; // -1 when empty
+    };
+
+    std::vector<Slot> table;
+    std::vector<uint64_t> ring;
+    long long first, last; // generations observed since clear(), -1 before any
+    int period;
+    long long start;
+
+public:
+    CycleDetector();
+
+    // basic funcs
+    void clear();
+    void rewind(long long generation);
+    int observe(long long generation, uint64_t digest);
+
+    // calculation operation
+    long long Last() const;
+    int Period() const;
+    long long Start() const;
+};
+
+// What one grid word adds to a board digest, the digest is the sum over all
+// words. Zero words add nothing, so a changed word updates the digest in
+// constant time and an empty board of any size has digest 0.
+inline uint64_t word_digest(uint64_t index, uint64_t word)
+{
+    return word ? mix64(word ^ mix64(index + 0x9e3779b97f4a7c15ULL)) : 0;
+}
+
+#endif // CYCLE_H
@@ -0,0 +1,49 @@
+# The simulation engine, everything that runs without QtWidgets.
+# Included by the application, the engine library and the benchmarks.
+
+INCLUDEPATH += $$PWD
+
+# qmake CONFIG+=profile compiles in the stage timers of profiler.h
+profile: DEFINES += LIFE_PROFILE
+
+# simd.h passes vector types between inlined templates, GCC warns about
+# the ABI those would have if they were ever real calls
+*-g++*: QMAKE_CXXFLAGS += -Wno-psabi
+
+SOURCES += \
+    $$PWD/board.cpp \
+    $$PWD/rule.cpp \
+    $$PWD/cycle.cpp \
+    $$PWD/grid.cpp \
+    $$PWD/pool.cpp \
+    $$PWD/history.cpp \
+    $$PWD/pyramid.cpp \
+    $$PWD/hashlife.cpp \
+    $$PWD/plane.cpp \
+    $$PWD/mappedfile.cpp \
+    $$PWD/pattern.cpp \
+    $$PWD/checkpoint.cpp \
+    $$PWD/ensemble.cpp \
+    $$PWD/profiler.cpp \
+    $$PWD/simd.cpp \
+    $$PWD/series.cpp
+
+HEADERS += \
+    $$PWD/board.h \
+    $$PWD/rule.h \
+    $$PWD/cycle.h \
+    $$PWD/kernel.h \
+    $$PWD/prng.h \
+    $$PWD/grid.h \
+    $$PWD/pool.h \
+    $$PWD/history.h \
+    $$PWD/pyramid.h \
+    $$PWD/hashlife.h \
+    $$PWD/plane.h \
+    $$PWD/mappedfile.h \
+    $$PWD/pattern.h \
+    $$PWD/checkpoint.h \
+    $$PWD/ensemble.h \
+    $$PWD/profiler.h \
+    $$PWD/simd.h \
+    $$PWD/series.h
@@ -0,0 +1,13 @@
+#-------------------------------------------------
+#
+# Static library of the simulation engine, no widgets
+#
+#-------------------------------------------------
+
+CONFIG   -= qt
+
+TARGET = engine
+TEMPLATE = lib
+CONFIG += staticlib c++11 thread
+
+include(../engine.pri)
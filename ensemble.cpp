@@ -0,0 +1,175 @@
+#include "ensemble.h"
+#include <chrono>
+
+Ensemble::Ensemble(int w, int h)
+    : width(w), height(h), boundary(Board::DEAD_BORDER), density(0.5), limit(1000),
+      pool(nullptr), seconds(0), steals(0)
+{
+    set_threads(1);
+}
+
+Ensemble::~Ensemble()
+{
+    delete pool;
+}
+
+int Ensemble::Threads()
+{
+    return pool->Threads();
+}
+
+int Ensemble::set_threads(int n)
+{
+    if (n < 1) {
+        return RET_ERROR;
+    }
+    if (!pool || pool->Threads() != n) {
+        delete pool;
+        pool = new WorkerPool(n);
+        queues.clear();
+        for (int i = 0; i < n; ++i) {
+            queues.emplace_back(new Queue);
+        }
+    }
+    return RET_OK;
+}
+
+int Ensemble::set_rule(const Rule &r)
+{
+    rule = r;
+    return RET_OK;
+}
+
+int Ensemble::set_boundary(Board::BOUNDARY b)
+{
+    if (b != Board::DEAD_BORDER && b != Board::TORUS && b != Board::MIRROR) {
+        return RET_ERROR;
+    }
+    boundary = b;
+    return RET_OK;
+}
+
+int Ensemble::set_density(double d)
+{
+    if (!(0 <= d && d <= 1)) {
+        return RET_ERROR;
+    }
+    density = d;
+    return RET_OK;
+}
+
+int Ensemble::set_limit(int generations)
+{
+    if (generations < 0) {
+        return RET_ERROR;
+    }
+    limit = generations;
+    return RET_OK;
+}
+
+// the own queue is worked from the back, others are robbed from the front
+bool Ensemble::take(int id, size_t &item, long long &stolen)
+{
+    {
+        Queue &own = *queues[id];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.items.empty()) {
+            item = own.items.back();
+            own.items.pop_back();
+            return true;
+        }
+    }
+    int n = (int)queues.size();
+    for (int k = 1; k < n; ++k) {
+        Queue &other = *queues[(id + k) % n];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.items.empty()) {
+            item = other.items.front();
+            other.items.pop_front();
+            stolen += 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Ensemble::work(int id, long long &stolen)
+{
+    if (!Board::is_legal_size(width, height)) {
+        return;
+    }
+    Board board(width, height);
+    board.set_history_budget(0);
+    board.set_rule(rule);
+    board.set_boundary(boundary);
+    size_t item;
+    while (take(id, item, stolen)) {
+        Result &r = results[item];
+        auto start = std::chrono::steady_clock::now();
+        board.randomize(r.seed, density);
+        int g = 0;
+        while (g < limit && !board.Period()) {
+            board.evolve();
+            g += 1;
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        r.generations = g;
+        r.period = board.Period();
+        r.lifetime = r.period ? board.PeriodStart() : -1;
+        r.population = board.cell_amount();
+        r.ms = elapsed.count();
+    }
+}
+
+int Ensemble::run(unsigned first, int count)
+{
+    if (count < 0 || !Board::is_legal_size(width, height)) {
+        return RET_ERROR;
+    }
+    results.assign(count, Result());
+    // contiguous shares to begin with, stealing balances the rest
+    int n = pool->Threads();
+    for (int i = 0; i < count; ++i) {
+        results[i].seed = first + (unsigned)i;
+        queues[(size_t)i * n / count]->items.push_back(i);
+    }
+    std::vector<long long> stolen(n, 0);
+    auto start = std::chrono::steady_clock::now();
+    pool->run([this, &stolen](int id) { work(id, stolen[id]); });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    seconds = elapsed.count();
+    steals = 0;
+    for (long long s : stolen) {
+        steals += s;
+    }
+    return RET_OK;
+}
+
+const std::vector<Ensemble::Result> &Ensemble::Results()
+{
+    return results;
+}
+
+double Ensemble::Seconds()
+{
+    return seconds;
+}
+
+double Ensemble::boards_per_second()
+{
+    return seconds > 0 ? results.size() / seconds : 0;
+}
+
+long long Ensemble::Steals()
+{
+    return steals;
+}
+
+void Ensemble::write_csv(FILE *out)
+{
+    fprintf(out, "seed,width,height,generations,lifetime,period,population,ms\n");
+    for (const Result &r : results) {
+        fprintf(out, "%u,%d,%d,%d,%d,%d,%d,%.3f\n", r.seed, width, height, r.generations, r.lifetime, r.period,
+                r.population, r.ms);
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "board.h"
+
+// Runs one randomized board per seed, many at a time, each until it
+// settles into a cycle or reaches the generation limit.
+// Every worker owns one board and a queue of seeds. It takes seeds from the
+// back of its own queue and, once that is empty, steals from the front of
+// another worker's queue, so boards that die young or live long even out
+// across the threads.
+class Ensemble
+{
+public:
+    struct Result {
+        unsigned seed;
+        int generations; // evolved before stopping
+        int lifetime; // generation the cycle began, -1 if it never settled
+        int period;
+        int population;
+        double ms;
+    };
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> items; // indices into results
+    };
+
+    int width, height;
+    Rule rule;
+    Board::BOUNDARY boundary;
+    double density;
+    int limit;
+    WorkerPool *pool;
+    std::vector<std::unique_ptr<Queue> > queues;
+    std::vector<Result> results;
+    double seconds;
+    long long steals;
+
+    bool take(int id, size_t &item, long long &stolen);
+    void work(int id, long long &stolen);
+
+public:
+    enum RETURN_VALUE {RET_ERROR = -1, RET_OK};
+
+    Ensemble(int w, int h);
+    ~Ensemble();
+    Ensemble(const Ensemble &) = delete;
+    Ensemble &operator=(const Ensemble &) = delete;
+
+    // basic funcs
+    int Threads();
+    int set_threads(int n);
+    int set_rule(const Rule &r);
+    int set_boundary(Board::BOUNDARY b);
+    int set_density(double d);
+    int set_limit(int generations);
+
+    // runs count seeds from first on, one board per seed
+    int run(unsigned first, int count);
+
+    // calculation operation
+    const std::vector<Result> &Results();
+    double Seconds();
+    double boards_per_second();
+    long long Steals();
+    void write_csv(FILE *out);
+};
+
+#endif // ENSEMBLE_H
@@ -0,0 +1,135 @@
+#include "frame.h"
+#include <algorithm>
+#include <cstring>
+
+Frame::Frame()
+    : has_prev(false), level(0), block_rows(0), block_columns(0), top(0), left(0), unbounded(false),
+      board_width(0), board_height(0), chunks(0), rounds(0), seed(0), boundary(Board::DEAD_BORDER), amount(0), borns(0), deads(0), period(0), period_start(-1), serial(0)
+{
+}
+
+// Whole words of cells or whole blocks are copied, so the window grows to
+// them, and it is cut to the board. Nothing outside it is touched: the
+// pyramid is only brought up to date when a level is needed.
+void Frame::capture(Board *board, unsigned long long _serial, int64_t _top, int64_t _left, int w, int h, int _level)
+{
+    int width = board->Width();
+    int height = board->Height();
+    int64_t r0 = std::min<int64_t>(std::max<int64_t>(_top, 0), height - 1);
+    int64_t c0 = std::min<int64_t>(std::max<int64_t>(_left, 0), width - 1);
+    int64_t r1 = std::min<int64_t>(std::max<int64_t>(_top + h, r0 + 1), height);
+    int64_t c1 = std::min<int64_t>(std::max<int64_t>(_left + w, c0 + 1), width);
+    const BitGrid *p = board->previous_grid();
+    has_prev = (p != nullptr);
+    if (_level < PYRAMID_BASE) {
+        const BitGrid &grid = board->current_grid();
+        int word = (int)(c0 / 64);
+        int rows = (int)(r1 - r0);
+        int columns = (int)std::min<int64_t>(((c1 + 63) / 64) * 64, width) - word * 64;
+        if (cur.Width() != columns || cur.Height() != rows) {
+            cur.resize(columns, rows);
+            prev.resize(columns, rows);
+        }
+        // bits past the board's last column are zero, so are the copies
+        size_t bytes = (size_t)cur.Words() * sizeof(uint64_t);
+        for (int r = 0; r < rows; ++r) {
+            memcpy(cur.row(r), grid.row((int)r0 + r) + word, bytes);
+            if (has_prev) {
+                memcpy(prev.row(r), p->row((int)r0 + r) + word, bytes);
+            }
+        }
+        level = 0;
+        top = r0;
+        left = word * 64;
+    } else {
+        const Pyramid &pyramid = board->pyramid();
+        int l = std::min(_level, pyramid.Top());
+        int size = 1 << l;
+        int64_t b0 = r0 >> l, b1 = (r1 + size - 1) >> l;
+        int64_t d0 = c0 >> l, d1 = (c1 + size - 1) >> l;
+        copy_level(pyramid, l, (int)b0, (int)d0, (int)(b1 - b0), (int)(d1 - d0));
+        top = b0 << l;
+        left = d0 << l;
+    }
+    unbounded = false;
+    board_width = width;
+    board_height = height;
+    chunks = 0;
+    rounds = board->Rounds();
+    seed = board->Seed();
+    rule = board->ActiveRule();
+    boundary = board->Boundary();
+    amount = board->cell_amount();
+    borns = board->increment();
+    deads = board->decrement();
+    period = board->Period();
+    period_start = board->PeriodStart();
+    serial = _serial;
+}
+
+// the window is redrawn from the chunks every time, it moves with the view
+void Frame::capture(Plane *plane, unsigned long long _serial, int64_t _top, int64_t _left, int w, int h, int _level)
+{
+    if (cur.Width() != w || cur.Height() != h) {
+        cur.resize(w, h);
+        prev.resize(w, h);
+        counter.resize(w, h);
+    }
+    has_prev = plane->Rounds() > 0;
+    plane->extract(cur, has_prev ? &prev : nullptr, _top, _left);
+    level = 0;
+    if (_level >= PYRAMID_BASE) {
+        counter.touch_all();
+        counter.update(cur);
+        int l = std::min(_level, counter.Top());
+        copy_level(counter, l, 0, 0, counter.Rows(l), counter.Columns(l));
+    }
+    top = _top;
+    left = _left;
+    unbounded = true;
+    board_width = board_height = 0;
+    chunks = plane->Chunks();
+    rounds = plane->Rounds();
+    seed = 0;
+    rule = plane->ActiveRule();
+    boundary = Board::DEAD_BORDER;
+    amount = plane->cell_amount();
+    borns = plane->increment();
+    deads = plane->decrement();
+    period = 0;
+    period_start = -1;
+    serial = _serial;
+}
+
+// blocks row..row + rows - 1 and column..column + columns - 1 of level l
+void Frame::copy_level(const Pyramid &pyramid, int l, int row, int column, int rows, int columns)
+{
+    level = l;
+    block_rows = rows;
+    block_columns = columns;
+    blocks.resize((size_t)rows * columns);
+    for (int r = 0; r < rows; ++r) {
+        const uint32_t *src = pyramid.row(l, row + r) + column;
+        std::copy(src, src + columns, &blocks[(size_t)r * columns]);
+    }
+}
+
+int Frame::Width() const
+{
+    return cur.Width();
+}
+
+int Frame::Height() const
+{
+    return cur.Height();
+}
+
+Board::CELL_STATE Frame::state(int row, int column) const
+{
+    int now = cur.get(row, column);
+    if (has_prev && prev.get(row, column)) {
+        return now ? Board::STILL_ALIVE : Board::NEW_DEAD;
+    } else {
+        return now ? Board::NEW_BORN : Board::STILL_NULL;
+    }
+}
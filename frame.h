@@ -0,0 +1,47 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <vector>
+#include "board.h"
+#include "plane.h"
+
+// A self-contained copy of one generation, everything Screen needs to
+// draw it without touching the board. Only a window around the view is
+// captured: its cells while each cell is at least a pixel, else the blocks
+// of the one pyramid level drawn at that zoom. top and left place the
+// window in the world.
+class Frame
+{
+private:
+    Pyramid counter; // counts a plane window before its level is copied
+
+    void copy_level(const Pyramid &pyramid, int l, int row, int column, int rows, int columns);
+
+public:
+    BitGrid cur, prev; // cells of the window while level is 0
+    bool has_prev;
+    int level; // 0 for cells, else the pyramid level of blocks
+    int block_rows, block_columns;
+    std::vector<uint32_t> blocks; // alive cells per block, row by row
+    int64_t top, left;
+    bool unbounded;
+    int board_width, board_height; // the whole board, 0 for a plane
+    size_t chunks;
+    long long rounds;
+    unsigned seed;
+    Rule rule;
+    Board::BOUNDARY boundary;
+    long long amount;
+    long long borns, deads;
+    int period, period_start; // 0 and -1 until the board repeats
+    unsigned long long serial;
+
+    Frame();
+    void capture(Board *board, unsigned long long _serial, int64_t _top, int64_t _left, int w, int h, int _level);
+    void capture(Plane *plane, unsigned long long _serial, int64_t _top, int64_t _left, int w, int h, int _level);
+    int Width() const;
+    int Height() const;
+    Board::CELL_STATE state(int row, int column) const;
+};
+
+#endif // FRAME_H
@@ -0,0 +1,156 @@
+#include "grid.h"
+#include "kernel.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+BitGrid::BitGrid()
+    : width(0), height(0), words(0), stride(0), buffer(nullptr), origin(nullptr)
+{
+}
+
+BitGrid::BitGrid(int w, int h)
+    : BitGrid()
+{
+    resize(w, h);
+}
+
+BitGrid::BitGrid(const BitGrid &other)
+    : BitGrid()
+{
+    *this = other;
+}
+
+BitGrid &BitGrid::operator=(const BitGrid &other)
+{
+    if (this != &other) {
+        if (width != other.width || height != other.height) {
+            resize(other.width, other.height);
+        }
+        if (buffer) {
+            memcpy(row(-1) - GRID_ALIGN, other.row(-1) - GRID_ALIGN,
+                   (size_t)(height + 2) * stride * sizeof(uint64_t));
+        }
+    }
+    return *this;
+}
+
+BitGrid::~BitGrid()
+{
+    delete[] buffer;
+}
+
+int BitGrid::Width() const
+{
+    return width;
+}
+
+int BitGrid::Height() const
+{
+    return height;
+}
+
+int BitGrid::Words() const
+{
+    return words;
+}
+
+int BitGrid::Stride() const
+{
+    return stride;
+}
+
+void BitGrid::resize(int w, int h)
+{
+    delete[] buffer;
+    buffer = origin = nullptr;
+    width = w;
+    height = h;
+    words = (w + 63) / 64;
+    // one leading line holds the left halo word in its last slot, the
+    // data is followed by at least one zero word for the right halo
+    stride = GRID_ALIGN + (words + GRID_ALIGN) / GRID_ALIGN * GRID_ALIGN;
+    if (w > 0 && h > 0) {
+        size_t total = (size_t)(h + 2) * stride;
+        buffer = new uint64_t[total + GRID_ALIGN];
+        uintptr_t addr = reinterpret_cast<uintptr_t>(buffer);
+        uintptr_t line = GRID_ALIGN * sizeof(uint64_t);
+        uint64_t *base = reinterpret_cast<uint64_t *>((addr + line - 1) / line * line);
+        origin = base + stride + GRID_ALIGN;
+        memset(base, 0, total * sizeof(uint64_t));
+    }
+}
+
+void BitGrid::swap(BitGrid &other)
+{
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(words, other.words);
+    std::swap(stride, other.stride);
+    std::swap(buffer, other.buffer);
+    std::swap(origin, other.origin);
+}
+
+uint64_t BitGrid::tail_mask() const
+{
+    return (width % 64) ? ((uint64_t)1 << (width % 64)) - 1 : ~(uint64_t)0;
+}
+
+uint64_t *BitGrid::row(int r)
+{
+    return origin + (ptrdiff_t)r * stride;
+}
+
+const uint64_t *BitGrid::row(int r) const
+{
+    return origin + (ptrdiff_t)r * stride;
+}
+
+int BitGrid::get(int r, int c) const
+{
+    return (row(r)[c / 64] >> (c % 64)) & 1;
+}
+
+void BitGrid::set(int r, int c, int value)
+{
+    uint64_t bit = (uint64_t)1 << (c % 64);
+    if (value) {
+        row(r)[c / 64] |= bit;
+    } else {
+        row(r)[c / 64] &= ~bit;
+    }
+}
+
+// sets n cells alive from (r, c) on, a word at a time
+void BitGrid::fill(int r, int c, int n)
+{
+    uint64_t *w = row(r);
+    while (n > 0) {
+        int bit = c % 64;
+        int take = std::min(n, 64 - bit);
+        uint64_t mask = (take == 64) ? ~(uint64_t)0 : (((uint64_t)1 << take) - 1) << bit;
+        w[c / 64] |= mask;
+        c += take;
+        n -= take;
+    }
+}
+
+void BitGrid::clear()
+{
+    for (int r = 0; r < height; ++r) {
+        memset(row(r), 0, words * sizeof(uint64_t));
+    }
+}
+
+int BitGrid::count() const
+{
+    int cnt = 0;
+    for (int r = 0; r < height; ++r) {
+        const uint64_t *w = row(r);
+        for (int i = 0; i < words; ++i) {
+            cnt += popcount64(w[i]);
+        }
+    }
+    return cnt;
+}
@@ -0,0 +1,521 @@
+#include "hashlife.h"
+#include <algorithm>
+#include <climits>
+
+static inline uint64_t hash_quad(HashLife::Node nw, HashLife::Node ne, HashLife::Node sw, HashLife::Node se)
+{
+    uint64_t h = nw;
+    h = h * 0x9e3779b97f4a7c15ULL + ne;
+    h = h * 0x9e3779b97f4a7c15ULL + sw;
+    h = h * 0x9e3779b97f4a7c15ULL + se;
+    return h ^ (h >> 29);
+}
+
+HashLife::HashLife()
+    : limit(HASHLIFE_MAX_NODES)
+{
+    initialize();
+}
+
+long long HashLife::Rounds()
+{
+    return rounds;
+}
+
+size_t HashLife::Nodes()
+{
+    return nodes.size();
+}
+
+int HashLife::set_limit(size_t n)
+{
+    if (n < 1024) {
+        return RET_ERROR;
+    }
+    limit = n;
+    return RET_OK;
+}
+
+int HashLife::initialize()
+{
+    nodes.clear();
+    jumps.clear();
+    empties.clear();
+    // the two leaves, level 0
+    Quad leaf = {NONE, NONE, NONE, NONE, NONE, 0, 0};
+    nodes.push_back(leaf);
+    leaf.population = 1;
+    nodes.push_back(leaf);
+    rehash(1 << 16);
+    root = empty_node(3);
+    left = top = 0;
+    rounds = 0;
+    return RET_OK;
+}
+
+void HashLife::rehash(size_t size)
+{
+    table.assign(size, NONE);
+    for (Node n = ALIVE + 1; n < nodes.size(); ++n) {
+        const Quad &q = nodes[n];
+        size_t i = hash_quad(q.nw, q.ne, q.sw, q.se) & (size - 1);
+        while (table[i] != NONE) {
+            i = (i + 1) & (size - 1);
+        }
+        table[i] = n;
+    }
+}
+
+HashLife::Node HashLife::join(Node nw, Node ne, Node sw, Node se)
+{
+    size_t mask = table.size() - 1;
+    size_t i = hash_quad(nw, ne, sw, se) & mask;
+    while (table[i] != NONE) {
+        const Quad &q = nodes[table[i]];
+        if (q.nw == nw && q.ne == ne && q.sw == sw && q.se == se) {
+            return table[i];
+        }
+        i = (i + 1) & mask;
+    }
+    Quad q = {nw, ne, sw, se, NONE, nodes[nw].level + 1,
+              nodes[nw].population + nodes[ne].population + nodes[sw].population + nodes[se].population};
+    Node n = (Node)nodes.size();
+    nodes.push_back(q);
+    table[i] = n;
+    if (nodes.size() * 2 > table.size()) {
+        rehash(table.size() * 2);
+    }
+    return n;
+}
+
+HashLife::Node HashLife::empty_node(int level)
+{
+    if (empties.empty()) {
+        empties.push_back(DEAD);
+    }
+    while ((int)empties.size() <= level) {
+        Node e = empties.back();
+        empties.push_back(join(e, e, e, e));
+    }
+    return empties[level];
+}
+
+HashLife::Node HashLife::centre(Node n)
+{
+    Quad q = nodes[n];
+    return join(nodes[q.nw].se, nodes[q.ne].sw, nodes[q.sw].ne, nodes[q.se].nw);
+}
+
+// the same cells, one level up and surrounded by empty space
+HashLife::Node HashLife::expand(Node n)
+{
+    Quad q = nodes[n];
+    Node e = empty_node(q.level - 1);
+    return join(join(e, e, e, q.nw), join(e, e, q.ne, e),
+                join(e, q.sw, e, e), join(q.se, e, e, e));
+}
+
+// one generation of the centre 2x2 of a 4x4 node
+HashLife::Node HashLife::base(Node n)
+{
+    Quad q = nodes[n];
+    int cells[4][4];
+    Node quads[2][2] = {{q.nw, q.ne}, {q.sw, q.se}};
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 0; x < 2; ++x) {
+            const Quad &s = nodes[quads[y][x]];
+            cells[y * 2][x * 2] = (s.nw == ALIVE);
+            cells[y * 2][x * 2 + 1] = (s.ne == ALIVE);
+            cells[y * 2 + 1][x * 2] = (s.sw == ALIVE);
+            cells[y * 2 + 1][x * 2 + 1] = (s.se == ALIVE);
+        }
+    }
+    Node result[2][2];
+    for (int y = 1; y <= 2; ++y) {
+        for (int x = 1; x <= 2; ++x) {
+            int count = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    count += (dy || dx) ? cells[y + dy][x + dx] : 0;
+                }
+            }
+            result[y - 1][x - 1] = rule.next(cells[y][x], count) ? ALIVE : DEAD;
+        }
+    }
+    return join(result[0][0], result[0][1], result[1][0], result[1][1]);
+}
+
+// the centre of n (one level down) advanced by 2^j generations, j <= level - 2
+HashLife::Node HashLife::advance(Node n, int j)
+{
+    Quad q = nodes[n];
+    if (q.population == 0) {
+        return empty_node(q.level - 1);
+    }
+    bool full = (j == q.level - 2);
+    uint64_t key = ((uint64_t)n << 6) | (uint64_t)j;
+    if (full && q.next != NONE) {
+        return q.next;
+    }
+    if (!full) {
+        std::unordered_map<uint64_t, Node>::iterator it = jumps.find(key);
+        if (it != jumps.end()) {
+            return it->second;
+        }
+    }
+
+    Node result;
+    if (q.level == 2) {
+        result = base(n);
+    } else {
+        Quad nw = nodes[q.nw], ne = nodes[q.ne], sw = nodes[q.sw], se = nodes[q.se];
+        // the nine overlapping sub-squares one level down
+        Node sub[3][3] = {
+            {q.nw, join(nw.ne, ne.nw, nw.se, ne.sw), q.ne},
+            {join(nw.sw, nw.se, sw.nw, sw.ne), join(nw.se, ne.sw, sw.ne, se.nw), join(ne.sw, ne.se, se.nw, se.ne)},
+            {q.sw, join(sw.ne, se.nw, sw.se, se.sw), q.se},
+        };
+        Node part[3][3];
+        for (int y = 0; y < 3; ++y) {
+            for (int x = 0; x < 3; ++x) {
+                // at full speed both halves of the jump advance, otherwise only the second
+                part[y][x] = full ? advance(sub[y][x], j - 1) : centre(sub[y][x]);
+            }
+        }
+        int step = full ? j - 1 : j;
+        Node a = advance(join(part[0][0], part[0][1], part[1][0], part[1][1]), step);
+        Node b = advance(join(part[0][1], part[0][2], part[1][1], part[1][2]), step);
+        Node c = advance(join(part[1][0], part[1][1], part[2][0], part[2][1]), step);
+        Node d = advance(join(part[1][1], part[1][2], part[2][1], part[2][2]), step);
+        result = join(a, b, c, d);
+    }
+
+    if (full) {
+        nodes[n].next = result;
+    } else {
+        jumps[key] = result;
+    }
+    return result;
+}
+
+int HashLife::jump(long long generations)
+{
+    if (generations < 0) {
+        return RET_ERROR;
+    }
+    for (int j = 0; generations; ++j, generations >>= 1) {
+        if (!(generations & 1)) {
+            continue;
+        }
+        if (nodes.size() > limit) {
+            collect();
+        }
+        // the pattern may grow by 2^j cells each way, keep that much room
+        // around it so the centre that advance() returns still holds it all
+        while (nodes[root].level < j + 2 || nodes[root].population != nodes[centre(root)].population) {
+            int64_t half = (int64_t)1 << (nodes[root].level - 1);
+            root = expand(root);
+            left -= half;
+            top -= half;
+        }
+        root = advance(expand(root), j);
+        rounds += (long long)1 << j;
+    }
+    return RET_OK;
+}
+
+// drops every node that the current root does not reach
+int HashLife::collect()
+{
+    std::vector<Node> remap(nodes.size(), NONE);
+    std::vector<Node> stack;
+    remap[DEAD] = DEAD;
+    remap[ALIVE] = ALIVE;
+    std::vector<Quad> kept(nodes.begin(), nodes.begin() + ALIVE + 1);
+    // children are numbered before their parents, so a post-order walk
+    // keeps that property in the compacted array
+    stack.push_back(root);
+    while (!stack.empty()) {
+        Node n = stack.back();
+        if (remap[n] != NONE) {
+            stack.pop_back();
+            continue;
+        }
+        const Quad &q = nodes[n];
+        bool ready = true;
+        Node children[4] = {q.nw, q.ne, q.sw, q.se};
+        for (int i = 0; i < 4; ++i) {
+            if (remap[children[i]] == NONE) {
+                stack.push_back(children[i]);
+                ready = false;
+            }
+        }
+        if (ready) {
+            Quad copy = q;
+            copy.nw = remap[q.nw];
+            copy.ne = remap[q.ne];
+            copy.sw = remap[q.sw];
+            copy.se = remap[q.se];
+            remap[n] = (Node)kept.size();
+            kept.push_back(copy);
+            stack.pop_back();
+        }
+    }
+    for (size_t i = ALIVE + 1; i < kept.size(); ++i) {
+        kept[i].next = (kept[i].next != NONE) ? remap[kept[i].next] : NONE;
+    }
+    root = remap[root];
+    nodes.swap(kept);
+    jumps.clear();
+    empties.clear();
+    size_t size = 1 << 16;
+    while (size < nodes.size() * 2) {
+        size *= 2;
+    }
+    rehash(size);
+    return RET_OK;
+}
+
+HashLife::Node HashLife::build(const BitGrid &grid, int level, int row, int column)
+{
+    if (row >= grid.Height() || column >= grid.Width()) {
+        return empty_node(level);
+    }
+    if (level == 0) {
+        return grid.get(row, column) ? ALIVE : DEAD;
+    }
+    if (level == 6) {
+        // a 64x64 square covers exactly one word of 64 rows
+        bool blank = true;
+        for (int r = row; r < row + 64 && r < grid.Height() && blank; ++r) {
+            blank = (grid.row(r)[column / 64] == 0);
+        }
+        if (blank) {
+            return empty_node(level);
+        }
+    }
+    int half = 1 << (level - 1);
+    return join(build(grid, level - 1, row, column), build(grid, level - 1, row, column + half),
+                build(grid, level - 1, row + half, column), build(grid, level - 1, row + half, column + half));
+}
+
+// the node cache is kept, patterns seen before advance from memory
+int HashLife::load(Board *board)
+{
+    Rule r = board->ActiveRule();
+    if ((r.born & 1) || board->Boundary() != Board::DEAD_BORDER) {
+        return RET_ERROR;
+    }
+    // remembered futures only hold for the rule they were computed with
+    if (nodes.size() > limit || r != rule) {
+        rule = r;
+        initialize();
+    }
+    const BitGrid &grid = board->current_grid();
+    int level = 3;
+    while ((1 << level) < grid.Width() || (1 << level) < grid.Height()) {
+        level += 1;
+    }
+    root = build(grid, level, 0, 0);
+    left = top = 0;
+    rounds = board->Rounds();
+    return RET_OK;
+}
+
+void HashLife::paint(BitGrid &grid, Node n, int64_t row, int64_t column)
+{
+    const Quad &q = nodes[n];
+    int64_t size = (int64_t)1 << q.level;
+    if (q.population == 0 || row >= grid.Height() || column >= grid.Width() || row + size <= 0 || column + size <= 0) {
+        return;
+    }
+    if (q.level == 0) {
+        grid.set((int)row, (int)column, 1);
+        return;
+    }
+    int64_t half = size / 2;
+    Node nw = q.nw, ne = q.ne, sw = q.sw, se = q.se;
+    paint(grid, nw, row, column);
+    paint(grid, ne, row, column + half);
+    paint(grid, sw, row + half, column);
+    paint(grid, se, row + half, column + half);
+}
+
+int HashLife::store(Board *board)
+{
+    if (rounds > INT_MAX) {
+        return RET_ERROR;
+    }
+    BitGrid grid(board->Width(), board->Height());
+    paint(grid, root, top, left);
+    return board->replace(grid, (int)rounds);
+}
+
+// one 64x64 square, row and column within it
+HashLife::Node HashLife::build(const uint64_t *cells, int level, int row, int column)
+{
+    if (level == 0) {
+        return (cells[row] >> column & 1) ? ALIVE : DEAD;
+    }
+    int half = 1 << (level - 1);
+    return join(build(cells, level - 1, row, column), build(cells, level - 1, row, column + half),
+                build(cells, level - 1, row + half, column), build(cells, level - 1, row + half, column + half));
+}
+
+// squares [begin, end) lie in the node of the given level whose upper left
+// square is at row and column, counted in chunks
+HashLife::Node HashLife::build(std::vector<const Plane::Square *>::iterator begin,
+                               std::vector<const Plane::Square *>::iterator end, int level, int64_t row, int64_t column)
+{
+    if (begin == end) {
+        return empty_node(level);
+    }
+    if (level == 6) {
+        return build((*begin)->cells, 6, 0, 0);
+    }
+    int64_t half = (int64_t)1 << (level - 7);
+    auto south = std::partition(begin, end, [&](const Plane::Square *s) { return s->row < row + half; });
+    auto ne = std::partition(begin, south, [&](const Plane::Square *s) { return s->column < column + half; });
+    auto se = std::partition(south, end, [&](const Plane::Square *s) { return s->column < column + half; });
+    return join(build(begin, ne, level - 1, row, column), build(ne, south, level - 1, row, column + half),
+                build(south, se, level - 1, row + half, column), build(se, end, level - 1, row + half, column + half));
+}
+
+int HashLife::load(Plane *plane)
+{
+    Rule r = plane->ActiveRule();
+    if (r.born & 1) {
+        return RET_ERROR;
+    }
+    if (nodes.size() > limit || r != rule) {
+        rule = r;
+        initialize();
+    }
+    std::vector<Plane::Square> squares;
+    plane->squares(squares);
+    std::vector<const Plane::Square *> order;
+    int64_t row = INT64_MAX, column = INT64_MAX, extent = 1;
+    for (const Plane::Square &s : squares) {
+        order.push_back(&s);
+        row = std::min<int64_t>(row, s.row);
+        column = std::min<int64_t>(column, s.column);
+    }
+    for (const Plane::Square &s : squares) {
+        extent = std::max(extent, std::max(s.row - row, s.column - column) + 1);
+    }
+    int level = 6;
+    while (((int64_t)1 << (level - 6)) < extent) {
+        level += 1;
+    }
+    if (order.empty()) {
+        row = column = 0;
+    }
+    root = build(order.begin(), order.end(), level, row, column);
+    top = row * CHUNK_SIZE;
+    left = column * 64;
+    rounds = plane->Rounds();
+    return RET_OK;
+}
+
+// cells are gathered into the squares of their chunks, index finds them
+void HashLife::paint(std::vector<Plane::Square> &squares, std::unordered_map<uint64_t, size_t> &index, Node n,
+                     int64_t row, int64_t column)
+{
+    const Quad &q = nodes[n];
+    if (q.population == 0) {
+        return;
+    }
+    if (q.level == 0) {
+        int64_t r = row >> 6, c = column >> 6;
+        if (r < INT32_MIN || r > INT32_MAX || c < INT32_MIN || c > INT32_MAX) {
+            return;
+        }
+        uint64_t key = ((uint64_t)(uint32_t)r << 32) | (uint32_t)c;
+        auto it = index.find(key);
+        if (it == index.end()) {
+            Plane::Square s = {(int32_t)r, (int32_t)c, {0}};
+            it = index.emplace(key, squares.size()).first;
+            squares.push_back(s);
+        }
+        squares[it->second].cells[row & 63] |= (uint64_t)1 << (column & 63);
+        return;
+    }
+    int64_t half = (int64_t)1 << (q.level - 1);
+    Node nw = q.nw, ne = q.ne, sw = q.sw, se = q.se;
+    paint(squares, index, nw, row, column);
+    paint(squares, index, ne, row, column + half);
+    paint(squares, index, sw, row + half, column);
+    paint(squares, index, se, row + half, column + half);
+}
+
+int HashLife::store(Plane *plane)
+{
+    std::vector<Plane::Square> squares;
+    std::unordered_map<uint64_t, size_t> index;
+    paint(squares, index, root, top, left);
+    return plane->replace(squares, rounds) == Plane::RET_OK ? RET_OK : RET_ERROR;
+}
+
+long long HashLife::cell_amount()
+{
+    return (long long)nodes[root].population;
+}
+
+Board::CELL_STATE HashLife::single_state(long long row, long long column)
+{
+    row -= top;
+    column -= left;
+    Node n = root;
+    int64_t size = (int64_t)1 << nodes[n].level;
+    if (row < 0 || column < 0 || row >= size || column >= size) {
+        return Board::STILL_NULL;
+    }
+    while (nodes[n].level > 0 && nodes[n].population) {
+        size /= 2;
+        const Quad &q = nodes[n];
+        if (row < size) {
+            n = (column < size) ? q.nw : q.ne;
+        } else {
+            n = (column < size) ? q.sw : q.se;
+        }
+        row %= size;
+        column %= size;
+    }
+    return nodes[n].population ? Board::STILL_ALIVE : Board::STILL_NULL;
+}
+
+// a node inside the rectangle found so far cannot widen it
+void HashLife::extent(Node n, int64_t row, int64_t column, int64_t &t, int64_t &l, int64_t &b, int64_t &r)
+{
+    const Quad &q = nodes[n];
+    int64_t size = (int64_t)1 << q.level;
+    if (q.population == 0 || (row >= t && column >= l && row + size - 1 <= b && column + size - 1 <= r)) {
+        return;
+    }
+    if (q.level == 0) {
+        t = std::min(t, row);
+        l = std::min(l, column);
+        b = std::max(b, row);
+        r = std::max(r, column);
+        return;
+    }
+    int64_t half = size / 2;
+    Node nw = q.nw, ne = q.ne, sw = q.sw, se = q.se;
+    extent(nw, row, column, t, l, b, r);
+    extent(ne, row, column + half, t, l, b, r);
+    extent(sw, row + half, column, t, l, b, r);
+    extent(se, row + half, column + half, t, l, b, r);
+}
+
+// the smallest rectangle holding every alive cell, b and r inclusive,
+// false when there is none
+bool HashLife::bounds(int64_t &t, int64_t &l, int64_t &b, int64_t &r)
+{
+    if (nodes[root].population == 0) {
+        return false;
+    }
+    t = l = INT64_MAX;
+    b = r = INT64_MIN;
+    extent(root, top, left, t, l, b, r);
+    return true;
+}
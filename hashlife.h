@@ -0,0 +1,87 @@
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#define HASHLIFE_MAX_NODES (1 << 22) // node cache size that triggers garbage collection
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "board.h"
+#include "plane.h"
+
+// Gosper's HashLife: the world is a quadtree of canonical, hash-consed
+// nodes and the future of every node is memoized, so repetitive patterns
+// can be advanced by billions of generations at once.
+// Unlike Board the plane is unbounded; load() and store() copy the cells
+// inside a board's rectangle in and out, cells that leave it are dropped
+// when the result is stored back. A Plane is copied in and out whole.
+class HashLife
+{
+public:
+    typedef uint32_t Node;
+
+private:
+    enum {NONE = 0xffffffffu, DEAD = 0, ALIVE = 1};
+
+    struct Quad {
+        Node nw, ne, sw, se;
+        Node next; // the centre advanced by 2^(level - 2) generations
+        int level;
+        uint64_t population;
+    };
+
+    std::vector<Quad> nodes;
+    std::vector<Node> table;
+    std::unordered_map<uint64_t, Node> jumps;
+    std::vector<Node> empties;
+    Node root;
+    int64_t left, top; // position of the root's upper left cell
+    long long rounds;
+    size_t limit;
+    Rule rule;
+
+    Node join(Node nw, Node ne, Node sw, Node se);
+    void rehash(size_t size);
+    Node empty_node(int level);
+    Node centre(Node n);
+    Node expand(Node n);
+    Node base(Node n);
+    Node advance(Node n, int j);
+    Node build(const BitGrid &grid, int level, int row, int column);
+    Node build(const uint64_t *cells, int level, int row, int column);
+    Node build(std::vector<const Plane::Square *>::iterator begin, std::vector<const Plane::Square *>::iterator end,
+               int level, int64_t row, int64_t column);
+    void paint(BitGrid &grid, Node n, int64_t row, int64_t column);
+    void paint(std::vector<Plane::Square> &squares, std::unordered_map<uint64_t, size_t> &index, Node n,
+               int64_t row, int64_t column);
+    void extent(Node n, int64_t row, int64_t column, int64_t &t, int64_t &l, int64_t &b, int64_t &r);
+
+public:
+    enum RETURN_VALUE {RET_ERROR = -1, RET_OK};
+
+    HashLife();
+
+    // basic funcs
+    long long Rounds();
+    size_t Nodes();
+    int set_limit(size_t nodes);
+    int initialize();
+
+    // board exchange, rules with B0 and wrapping boundaries cannot be run
+    // on an unbounded plane
+    int load(Board *board);
+    int store(Board *board);
+    int load(Plane *plane);
+    int store(Plane *plane);
+
+    // evolution operation
+    int jump(long long generations);
+    int collect();
+
+    // calculation operation
+    long long cell_amount();
+    bool bounds(int64_t &t, int64_t &l, int64_t &b, int64_t &r);
+    Board::CELL_STATE single_state(long long row, long long column);
+};
+
+#endif // HASHLIFE_H
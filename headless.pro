@@ -0,0 +1,17 @@
+#-------------------------------------------------
+#
+# Everything that builds without a display: the engine library and the
+# command line runner, plus the benchmarks where QtWidgets is installed,
+# they time the offscreen renderer too
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    engine \
+    cli
+
+cli.depends = engine
+
+qtHaveModule(widgets): SUBDIRS += bench
@@ -0,0 +1,159 @@
+#include "history.h"
+#include "kernel.h"
+
+History::History()
+    : position(0), budget(HISTORY_BUDGET), bytes(0)
+{
+}
+
+int History::Behind()
+{
+    return position;
+}
+
+int History::Ahead()
+{
+    return (int)deltas.size() - position;
+}
+
+size_t History::Bytes()
+{
+    return bytes;
+}
+
+size_t History::Budget()
+{
+    return budget;
+}
+
+void History::set_budget(size_t b)
+{
+    budget = b;
+    while (bytes > budget && position > 0) {
+        bytes -= size_of(deltas.front());
+        release(deltas.front());
+        deltas.pop_front();
+        position -= 1;
+    }
+}
+
+void History::clear()
+{
+    deltas.clear();
+    position = 0;
+    bytes = 0;
+}
+
+size_t History::size_of(const Delta &d)
+{
+    return d.where.size() * sizeof(uint32_t) + d.bits.size() * sizeof(uint64_t);
+}
+
+// the larger buffers of a dropped delta are kept for recycle()
+void History::release(Delta &d)
+{
+    if (d.where.capacity() > spare.where.capacity()) {
+        spare.where.swap(d.where);
+    }
+    if (d.bits.capacity() > spare.bits.capacity()) {
+        spare.bits.swap(d.bits);
+    }
+}
+
+// a delta to fill and push(); once the history is full push() leaves the
+// buffers of the oldest one here, so a long run stops allocating
+History::Delta &History::recycle()
+{
+    spare.where.clear();
+    spare.bits.clear();
+    spare.dense = false;
+    spare.borns = spare.deads = 0;
+    spare.generations = 1;
+    return spare;
+}
+
+// appends a new newest generation, anything that could be redone is lost
+void History::push(Delta &d)
+{
+    truncate();
+    bytes += size_of(d);
+    deltas.push_back(Delta());
+    deltas.back().where.swap(d.where);
+    deltas.back().bits.swap(d.bits);
+    deltas.back().dense = d.dense;
+    deltas.back().borns = d.borns;
+    deltas.back().deads = d.deads;
+    deltas.back().generations = d.generations;
+    position += 1;
+    set_budget(budget);
+}
+
+void History::truncate()
+{
+    while ((int)deltas.size() > position) {
+        bytes -= size_of(deltas.back());
+        release(deltas.back());
+        deltas.pop_back();
+    }
+}
+
+// before(1) leads to the current generation, before(2) to the one before it
+const History::Delta &History::before(int steps)
+{
+    return deltas[position - steps];
+}
+
+const History::Delta &History::after()
+{
+    return deltas[position];
+}
+
+void History::forward()
+{
+    position += 1;
+}
+
+void History::backward()
+{
+    position -= 1;
+}
+
+// keeps the delta into the current generation exact after a cell is edited
+void History::toggle(uint32_t index, uint64_t bit)
+{
+    if (position == 0) {
+        return;
+    }
+    Delta &d = deltas[position - 1];
+    if (d.dense) {
+        d.bits[index] ^= bit;
+    } else {
+        d.where.push_back(index);
+        d.bits.push_back(bit);
+        bytes += sizeof(uint32_t) + sizeof(uint64_t);
+    }
+}
+
+// returns how much the population changed
+int History::apply(BitGrid &grid, const Delta &d)
+{
+    int words = grid.Words();
+    int change = 0;
+    if (d.dense) {
+        const uint64_t *src = d.bits.data();
+        for (int r = 0; r < grid.Height(); ++r, src += words) {
+            uint64_t *dst = grid.row(r);
+            for (int w = 0; w < words; ++w) {
+                change += popcount64(src[w] & ~dst[w]) - popcount64(src[w] & dst[w]);
+                dst[w] ^= src[w];
+            }
+        }
+    } else {
+        for (size_t i = 0; i < d.where.size(); ++i) {
+            uint64_t &dst = grid.row(d.where[i] / words)[d.where[i] % words];
+            change += popcount64(d.bits[i] & ~dst) - popcount64(d.bits[i] & dst);
+            dst ^= d.bits[i];
+        }
+    }
+    return change;
+}
@@ -0,0 +1,61 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#define HISTORY_BUDGET (64 << 20) // default bytes of history per board
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "grid.h"
+
+// Undo history as a chain of XOR deltas between consecutive generations.
+// A delta turns generation g - 1 into g and, being an XOR, g back into
+// g - 1, so stepping either way costs only the changed words. Deltas that
+// touch most of the grid are kept as a dense XOR frame instead of a word
+// list, which bounds any single entry to the size of a full grid. The
+// oldest deltas are dropped once the total passes the budget.
+class History
+{
+public:
+    struct Delta {
+        std::vector<uint32_t> where; // word index r * Words() + w, unused when dense
+        std::vector<uint64_t> bits;
+        bool dense;
+        int borns, deads; // counters of the generation the delta leads to
+        int generations; // more than 1 for a batch advanced without deltas
+    };
+
+private:
+    std::deque<Delta> deltas;
+    int position; // number of deltas that lead up to the current generation
+    size_t budget, bytes;
+    Delta spare;
+
+    static size_t size_of(const Delta &d);
+    void release(Delta &d);
+
+public:
+    History();
+
+    // basic funcs
+    int Behind();
+    int Ahead();
+    size_t Bytes();
+    size_t Budget();
+    void set_budget(size_t b);
+    void clear();
+
+    // delta operation
+    Delta &recycle();
+    void push(Delta &d);
+    void truncate();
+    const Delta &before(int steps);
+    const Delta &after();
+    void forward();
+    void backward();
+    void toggle(uint32_t index, uint64_t bit);
+    static int apply(BitGrid &grid, const Delta &d);
+};
+
+#endif // HISTORY_H
@@ -0,0 +1,175 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Word-parallel life kernel.
+// Column c of a row lives in bit (c % 64) of word (c / 64), so the left
+// neighbour of every cell is obtained by shifting the row one bit up and
+// the right neighbour by shifting it one bit down.
+
+inline int popcount64(uint64_t x)
+{
+#ifdef _MSC_VER
+    return (int)__popcnt64(x);
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+// index of the lowest set bit, x must not be zero
+inline int lowest_bit64(uint64_t x)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (int)index;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// index of the highest set bit, x must not be zero
+inline int highest_bit64(uint64_t x)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(x);
+#endif
+}
+
+// The adders and kernels below are templates over T, a 64-bit word or a
+// vector of them, so the SIMD paths in simd.h run the very same logic.
+
+template <class T>
+inline void half_add(T a, T b, T &sum, T &carry)
+{
+    sum = a ^ b;
+    carry = a & b;
+}
+
+template <class T>
+inline void full_add(T a, T b, T c, T &sum, T &carry)
+{
+    T t = a ^ b;
+    sum = t ^ c;
+    carry = (a & b) | (t & c);
+}
+
+// Counts the eight neighbours of the 64 cells in each word of mid and
+// returns the count as four bit planes (count = s0 + 2*s1 + 4*s2 + 8*s3).
+// The l and r arguments are the words left and right of up, mid and down.
+template <class T>
+inline void neighbour_planes(T upl, T up, T upr, T midl, T mid, T midr, T downl, T down, T downr,
+                             T &s0, T &s1, T &s2, T &s3)
+{
+    T ul = (up << 1) | (upl >> 63);
+    T ur = (up >> 1) | (upr << 63);
+    T ml = (mid << 1) | (midl >> 63);
+    T mr = (mid >> 1) | (midr << 63);
+    T dl = (down << 1) | (downl >> 63);
+    T dr = (down >> 1) | (downr << 63);
+
+    T sa, ca, sb, cb, sc, cc, cd;
+    full_add(ul, up, ur, sa, ca);
+    full_add(ml, mr, dl, sb, cb);
+    half_add(down, dr, sc, cc);
+    full_add(sa, sb, sc, s0, cd);
+
+    T t, f0, f1;
+    full_add(ca, cb, cc, t, f0);
+    half_add(t, cd, s1, f1);
+    half_add(f0, f1, s2, s3);
+}
+
+// up, mid and down point at the same word of three adjacent rows, and
+// words [-1] and [1] of each row must be readable.
+inline void neighbour_count(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                            uint64_t &s0, uint64_t &s1, uint64_t &s2, uint64_t &s3)
+{
+    neighbour_planes(up[-1], up[0], up[1], mid[-1], mid[0], mid[1], down[-1], down[0], down[1], s0, s1, s2, s3);
+}
+
+// Rule kernels turn the count planes and the cells of a word into the
+// next generation of those cells. The common rules are written out as
+// plain bitwise expressions; any other rule goes through TableKernel.
+
+// B3/S23
+struct ConwayKernel {
+    template <class T>
+    T operator()(T s0, T s1, T s2, T s3, T mid) const
+    {
+        return s1 & ~s2 & ~s3 & (s0 | mid);
+    }
+};
+
+// B36/S23
+struct HighLifeKernel {
+    template <class T>
+    T operator()(T s0, T s1, T s2, T s3, T mid) const
+    {
+        return (s1 & ~s2 & ~s3 & (s0 | mid)) | (~mid & ~s0 & s1 & s2 & ~s3);
+    }
+};
+
+// B3678/S34678, only a count of 8 sets s3 so it needs no masking elsewhere
+struct DayAndNightKernel {
+    template <class T>
+    T operator()(T s0, T s1, T s2, T s3, T mid) const
+    {
+        return s3 | (s1 & (s0 | s2)) | (mid & s2 & ~s1 & ~s0);
+    }
+};
+
+// B2/S
+struct SeedsKernel {
+    template <class T>
+    T operator()(T s0, T s1, T s2, T s3, T mid) const
+    {
+        return ~mid & ~s0 & s1 & ~s2 & ~s3;
+    }
+};
+
+// Any rule from its tables: the cells whose count is n are found with one
+// minterm of the four planes and taken in when n is in the table. The
+// branches depend on the rule only, never on the cells.
+struct TableKernel {
+    uint32_t born, survive;
+
+    template <class T>
+    T operator()(T s0, T s1, T s2, T s3, T mid) const
+    {
+        T b = T(), s = T();
+        for (int n = 0; n <= 8; ++n) {
+            if (!(((born | survive) >> n) & 1)) {
+                continue;
+            }
+            T eq = ((n & 1) ? s0 : ~s0) & ((n & 2) ? s1 : ~s1) & ((n & 4) ? s2 : ~s2) & ((n & 8) ? s3 : ~s3);
+            if ((born >> n) & 1) {
+                b |= eq;
+            }
+            if ((survive >> n) & 1) {
+                s |= eq;
+            }
+        }
+        return (mid & s) | (~mid & b);
+    }
+};
+
+// the next generation of the 64 cells in mid[0]
+template <class Kernel>
+inline uint64_t evolve_word(const uint64_t *up, const uint64_t *mid, const uint64_t *down, const Kernel &kernel)
+{
+    uint64_t s0, s1, s2, s3;
+    neighbour_count(up, mid, down, s0, s1, s2, s3);
+    return kernel(s0, s1, s2, s3, mid[0]);
+}
+
+#endif // KERNEL_H
@@ -0,0 +1,118 @@
+#include "mappedfile.h"
+#include "board.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : data(nullptr), size(0)
+#ifdef _WIN32
+    , file(INVALID_HANDLE_VALUE), mapping(nullptr)
+#else
+    , fd(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+int MappedFile::open(const char *path)
+{
+    close();
+#ifdef _WIN32
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return Board::RET_ERROR;
+    }
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file, &length)) {
+        close();
+        return Board::RET_ERROR;
+    }
+    size = (size_t)length.QuadPart;
+    if (size == 0) {
+        data = "";
+        return Board::RET_OK;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        close();
+        return Board::RET_ERROR;
+    }
+    data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return Board::RET_ERROR;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close();
+        return Board::RET_ERROR;
+    }
+    size = (size_t)info.st_size;
+    if (size == 0) {
+        data = "";
+        return Board::RET_OK;
+    }
+    void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        close();
+        return Board::RET_ERROR;
+    }
+    // the file is read once from front to back
+    madvise(p, size, MADV_SEQUENTIAL);
+    data = (const char *)p;
+#endif
+    if (!data) {
+        close();
+        return Board::RET_ERROR;
+    }
+    return Board::RET_OK;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (data && size) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (data && size) {
+        munmap((void *)data, size);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd = -1;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+const char *MappedFile::Data() const
+{
+    return data;
+}
+
+size_t MappedFile::Size() const
+{
+    return size;
+}
@@ -0,0 +1,31 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+
+// A whole file mapped read-only into memory, so large inputs are parsed in
+// place without being copied into a buffer first.
+class MappedFile
+{
+private:
+    const char *data;
+    size_t size;
+#ifdef _WIN32
+    void *file, *mapping;
+#else
+    int fd;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    int open(const char *path);
+    void close();
+    const char *Data() const;
+    size_t Size() const;
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,324 @@
+#include "pattern.h"
+#include "kernel.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#define FLUSH_SIZE (1 << 20) // bytes collected before each write
+
+static const char *skip_line(const char *p, const char *end)
+{
+    if (p >= end) {
+        return end;
+    }
+    const char *n = (const char *)memchr(p, '\n', end - p);
+    return n ? n + 1 : end;
+}
+
+static int read_number(const char *&p, const char *end)
+{
+    long long n = 0;
+    while (p < end && '0' <= *p && *p <= '9') {
+        n = std::min(n * 10 + (*p - '0'), (long long)MAX_WIDTH + MAX_HEIGHT);
+        ++p;
+    }
+    return (int)n;
+}
+
+// the first line that is not a comment, "x = 3, y = 3, rule = B3/S23"
+static int rle_header(const char *&p, const char *end, int &w, int &h, std::string &rule)
+{
+    while (p < end && (*p == '#' || *p == '\n' || *p == '\r')) {
+        p = skip_line(p, end);
+    }
+    const char *line = p;
+    p = skip_line(p, end);
+    w = h = -1;
+    for (const char *q = line; q < p; ++q) {
+        if ((*q == 'x' || *q == 'y') && (q == line || q[-1] == ' ' || q[-1] == ',')) {
+            char axis = *q;
+            ++q;
+            while (q < p && (*q == ' ' || *q == '=')) {
+                ++q;
+            }
+            (axis == 'x' ? w : h) = read_number(q, p);
+            --q;
+        } else if (p - q > 4 && !strncmp(q, "rule", 4)) {
+            q += 4;
+            while (q < p && (*q == ' ' || *q == '=')) {
+                ++q;
+            }
+            const char *start = q;
+            while (q < p && *q != ',' && *q != '\n' && *q != '\r' && *q != ' ') {
+                ++q;
+            }
+            rule.assign(start, q);
+            --q;
+        }
+    }
+    return (w >= 0 && h >= 0) ? Board::RET_OK : Board::RET_ERROR;
+}
+
+// b or . is dead, o and the other letters of multi-state files are alive,
+// $ ends a row and ! the pattern; cells past the declared size are dropped
+static void rle_body(const char *p, const char *end, BitGrid &grid, int top, int left, int w, int h)
+{
+    int r = 0, c = 0;
+    while (p < end && *p != '!') {
+        char ch = *p;
+        if (ch == '#') {
+            p = skip_line(p, end);
+            continue;
+        }
+        int n = 1;
+        if ('0' <= ch && ch <= '9') {
+            n = read_number(p, end);
+            if (p == end) {
+                break;
+            }
+            ch = *p;
+        }
+        ++p;
+        if (ch == '$') {
+            r = std::min(r + n, h);
+            c = 0;
+        } else if (ch == 'b' || ch == '.') {
+            c = std::min(c + n, w);
+        } else if (('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z')) {
+            if (r < h && c < w) {
+                grid.fill(top + r, left + c, std::min(n, w - c));
+            }
+            c = std::min(c + n, w);
+        }
+    }
+}
+
+// '!' starts a comment line, the pattern is as wide as its longest line
+static void plaintext_size(const char *p, const char *end, int &w, int &h)
+{
+    w = h = 0;
+    while (p < end) {
+        const char *next = skip_line(p, end);
+        if (*p != '!') {
+            const char *last = next;
+            while (last > p && (last[-1] == '\n' || last[-1] == '\r')) {
+                --last;
+            }
+            w = (int)std::min<long long>(std::max<long long>(w, last - p), (long long)MAX_WIDTH + 1);
+            h = std::min(h + 1, MAX_HEIGHT + 1);
+        }
+        p = next;
+    }
+}
+
+static void plaintext_body(const char *p, const char *end, BitGrid &grid, int top, int left, int h)
+{
+    int r = 0;
+    while (p < end && r < h) {
+        const char *next = skip_line(p, end);
+        if (*p != '!') {
+            for (const char *q = p; q < next; ) {
+                if (*q != 'O' && *q != '*') {
+                    ++q;
+                    continue;
+                }
+                const char *run = q;
+                while (q < next && (*q == 'O' || *q == '*')) {
+                    ++q;
+                }
+                grid.fill(top + r, left + (int)(run - p), (int)(q - run));
+            }
+            r += 1;
+        }
+        p = next;
+    }
+}
+
+Pattern::FORMAT Pattern::format_of(const char *path)
+{
+    const char *dot = strrchr(path, '.');
+    if (dot && (!strcmp(dot, ".cells") || !strcmp(dot, ".txt"))) {
+        return PLAINTEXT;
+    }
+    return RLE;
+}
+
+int Pattern::load(Board *board, const char *path)
+{
+    MappedFile file;
+    if (file.open(path) != Board::RET_OK) {
+        return Board::RET_ERROR;
+    }
+    const char *p = file.Data(), *end = p + file.Size();
+
+    // RLE files begin with # comments or the x = ... header
+    const char *first = p;
+    while (first < end && (*first == '#' || *first == '\n' || *first == '\r')) {
+        first = (*first == '#') ? skip_line(first, end) : first + 1;
+    }
+    bool rle = (first < end && *first == 'x');
+    int w, h;
+    Rule rule = board->ActiveRule();
+    if (rle) {
+        std::string name;
+        if (rle_header(p, end, w, h, name) != Board::RET_OK) {
+            return Board::RET_ERROR;
+        }
+        if (!name.empty() && Rule::parse(name.c_str(), rule) != Board::RET_OK) {
+            return Board::RET_ERROR;
+        }
+    } else {
+        plaintext_size(p, end, w, h);
+    }
+    if (w > MAX_WIDTH || h > MAX_HEIGHT) {
+        return Board::RET_ERROR;
+    }
+
+    int width = std::max(board->Width(), w), height = std::max(board->Height(), h);
+    if ((width != board->Width() || height != board->Height()) && board->resize(width, height) != Board::RET_OK) {
+        return Board::RET_ERROR;
+    }
+    BitGrid grid(width, height);
+    int top = (height - h) / 2, left = (width - w) / 2;
+    if (rle) {
+        rle_body(p, end, grid, top, left, w, h);
+    } else {
+        plaintext_body(p, end, grid, top, left, h);
+    }
+    board->set_rule(rule);
+    return board->replace(grid, 0);
+}
+
+// first column from c on, up to limit, whose cell is not state
+static int next_change(const uint64_t *row, int c, int limit, int state)
+{
+    while (c < limit) {
+        uint64_t x = state ? ~row[c / 64] : row[c / 64];
+        x &= ~(uint64_t)0 << (c % 64);
+        if (x) {
+            return std::min(c / 64 * 64 + lowest_bit64(x), limit);
+        }
+        c = c / 64 * 64 + 64;
+    }
+    return limit;
+}
+
+class Writer
+{
+private:
+    FILE *file;
+    std::string buffer;
+    size_t line;
+
+public:
+    explicit Writer(FILE *f) : file(f), line(0) {}
+    void text(const char *s)
+    {
+        buffer += s;
+        if (buffer.size() >= FLUSH_SIZE) {
+            flush();
+        }
+    }
+    // an RLE item, lines are broken before they grow past RLE_LINE
+    void item(int n, char tag)
+    {
+        char s[16];
+        int len = (n > 1) ? snprintf(s, sizeof(s), "%d%c", n, tag) : snprintf(s, sizeof(s), "%c", tag);
+        if (line + len > RLE_LINE) {
+            text("\n");
+            line = 0;
+        }
+        text(s);
+        line += len;
+    }
+    int flush()
+    {
+        size_t n = fwrite(buffer.data(), 1, buffer.size(), file);
+        bool ok = (n == buffer.size());
+        buffer.clear();
+        return ok ? Board::RET_OK : Board::RET_ERROR;
+    }
+};
+
+int Pattern::save(Board *board, const char *path, FORMAT format)
+{
+    const BitGrid &grid = board->current_grid();
+    int top = grid.Height(), bottom = -1, left = grid.Width(), right = -1;
+    for (int r = 0; r < grid.Height(); ++r) {
+        const uint64_t *row = grid.row(r);
+        for (int i = 0; i < grid.Words(); ++i) {
+            if (row[i]) {
+                top = std::min(top, r);
+                bottom = r;
+                left = std::min(left, i * 64 + lowest_bit64(row[i]));
+                right = std::max(right, i * 64 + highest_bit64(row[i]));
+            }
+        }
+    }
+    if (bottom < 0) {
+        top = left = 0;
+        bottom = right = -1;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return Board::RET_ERROR;
+    }
+    Writer out(file);
+    char header[128];
+    if (format == RLE) {
+        snprintf(header, sizeof(header), "#C generation %d\nx = %d, y = %d, rule = %s\n",
+                 board->Rounds(), right - left + 1, bottom - top + 1, board->ActiveRule().name().c_str());
+        out.text(header);
+        int blank = 0; // rows ended but not yet written
+        for (int r = top; r <= bottom; ++r) {
+            const uint64_t *row = grid.row(r);
+            int c = left;
+            while (c <= right) {
+                int dead = next_change(row, c, right + 1, 0);
+                if (dead > right) {
+                    break;
+                }
+                if (blank) {
+                    out.item(blank, '$');
+                    blank = 0;
+                }
+                if (dead > c) {
+                    out.item(dead - c, 'b');
+                }
+                c = next_change(row, dead, right + 1, 1);
+                out.item(c - dead, 'o');
+            }
+            blank += 1;
+        }
+        out.text("!\n");
+    } else {
+        snprintf(header, sizeof(header), "!Generation: %d\n", board->Rounds());
+        out.text(header);
+        std::string line;
+        for (int r = top; r <= bottom; ++r) {
+            const uint64_t *row = grid.row(r);
+            line.clear();
+            for (int c = left; c <= right; ) {
+                int dead = next_change(row, c, right + 1, 0);
+                line.append(dead - c, '.');
+                if (dead > right) {
+                    break;
+                }
+                c = next_change(row, dead, right + 1, 1);
+                line.append(c - dead, 'O');
+            }
+            // trailing dead cells are left out
+            line.erase(line.find_last_not_of('.') + 1);
+            line += '\n';
+            out.text(line.c_str());
+        }
+    }
+    int ret = out.flush();
+    if (fclose(file) != 0) {
+        ret = Board::RET_ERROR;
+    }
+    return ret;
+}
@@ -0,0 +1,25 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#define RLE_LINE 70 // longest line written to an RLE file
+
+#include "board.h"
+
+// Pattern files in the two formats most collections use, RLE and plain
+// text (.cells). Files are memory mapped and parsed straight into the bit
+// grid, runs of live cells are set a word at a time.
+class Pattern
+{
+public:
+    enum FORMAT {RLE, PLAINTEXT};
+
+    static FORMAT format_of(const char *path);
+
+    // the board grows to hold the pattern, which is placed at its centre,
+    // and takes the rule of an RLE file
+    static int load(Board *board, const char *path);
+    // only the bounding box of the live cells is written
+    static int save(Board *board, const char *path, FORMAT format);
+};
+
+#endif // PATTERN_H
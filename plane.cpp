@@ -0,0 +1,516 @@
+#include "plane.h"
+#include "kernel.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+// the eight neighbours of a chunk, the opposite of direction d is 7 - d
+static const int AROUND_ROW[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+static const int AROUND_COLUMN[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+enum {NW, N, NE, W, E, SW, S, SE};
+
+// chunk coordinates stay clear of the int32 limits so that neighbours of
+// any chunk can still be named, cells beyond are lost
+#define CHUNK_LIMIT (INT32_MAX - 1)
+
+static bool in_range(int64_t chunk)
+{
+    return -CHUNK_LIMIT <= chunk && chunk <= CHUNK_LIMIT;
+}
+
+static bool is_empty(const uint64_t *cells)
+{
+    uint64_t any = 0;
+    for (int r = 0; r < CHUNK_SIZE; ++r) {
+        any |= cells[r];
+    }
+    return any == 0;
+}
+
+// ORs 64 cells into a grid row, x is the grid column of bit 0 and may lie
+// outside the grid
+static void put_word(uint64_t *row, int words, int64_t x, uint64_t bits)
+{
+    int64_t w = x >> 6;
+    int s = (int)(x & 63);
+    if (w >= 0 && w < words) {
+        row[w] |= bits << s;
+    }
+    if (s && w + 1 >= 0 && w + 1 < words) {
+        row[w + 1] |= bits >> (64 - s);
+    }
+}
+
+Plane::Plane()
+    : pool(nullptr), phase(0), has_previous(false), rounds(0), population(0), new_borns(0), new_deads(0)
+{
+    set_threads(1);
+}
+
+Plane::~Plane()
+{
+    initialize();
+    delete pool;
+}
+
+uint64_t Plane::key(int32_t row, int32_t column)
+{
+    return ((uint64_t)(uint32_t)row << 32) | (uint32_t)column;
+}
+
+Plane::Chunk *Plane::find(int32_t row, int32_t column) const
+{
+    auto it = chunks.find(key(row, column));
+    return it == chunks.end() ? nullptr : it->second;
+}
+
+Plane::Chunk *Plane::create(int32_t row, int32_t column)
+{
+    Chunk *chunk = new Chunk;
+    chunk->row = row;
+    chunk->column = column;
+    memset(chunk->cells, 0, sizeof(chunk->cells));
+    // a new chunk is computed at least once, along with its neighbours
+    chunk->changed = true;
+    chunk->awake = false;
+    chunk->slot = live.size();
+    live.push_back(chunk);
+    chunks[key(row, column)] = chunk;
+    return chunk;
+}
+
+void Plane::release(Chunk *chunk)
+{
+    Chunk *last = live.back();
+    live[chunk->slot] = last;
+    last->slot = chunk->slot;
+    live.pop_back();
+    chunks.erase(key(chunk->row, chunk->column));
+    delete chunk;
+}
+
+// bit d is set when live cells lie on the side or corner facing direction d
+int Plane::edges(const Chunk *chunk, int current) const
+{
+    const uint64_t *cells = chunk->cells[current];
+    uint64_t west = 0, east = 0;
+    for (int r = 0; r < CHUNK_SIZE; ++r) {
+        west |= cells[r];
+        east |= cells[r];
+    }
+    west &= 1;
+    east >>= 63;
+    uint64_t top = cells[0], bottom = cells[CHUNK_SIZE - 1];
+    return (int)(top & 1) << NW | (top != 0) << N | (int)(top >> 63) << NE |
+           (int)west << W | (int)east << E |
+           (int)(bottom & 1) << SW | (bottom != 0) << S | (int)(bottom >> 63) << SE;
+}
+
+// cells may be born next to live edges, the chunks there must exist
+void Plane::grow(Chunk *chunk)
+{
+    int sides = edges(chunk, phase);
+    for (int d = 0; d < 8; ++d) {
+        if (!(sides >> d & 1)) {
+            continue;
+        }
+        int64_t row = (int64_t)chunk->row + AROUND_ROW[d];
+        int64_t column = (int64_t)chunk->column + AROUND_COLUMN[d];
+        if (in_range(row) && in_range(column) && !find((int32_t)row, (int32_t)column)) {
+            create((int32_t)row, (int32_t)column);
+        }
+    }
+}
+
+// an empty chunk is kept while a neighbour's live edge faces it, or it
+// would be freed and grown again every generation
+bool Plane::needed(const Chunk *chunk) const
+{
+    for (int d = 0; d < 8; ++d) {
+        const Chunk *n = find(chunk->row + AROUND_ROW[d], chunk->column + AROUND_COLUMN[d]);
+        if (n && (edges(n, phase) >> (7 - d) & 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+long long Plane::Rounds()
+{
+    return rounds;
+}
+
+size_t Plane::Chunks()
+{
+    return live.size();
+}
+
+// an estimate of the heap in use, the chunks plus the hash map around them
+size_t Plane::bytes()
+{
+    return live.size() * (sizeof(Chunk) + sizeof(Chunk *) + sizeof(std::pair<uint64_t, Chunk *>) + 2 * sizeof(void *)) +
+           chunks.bucket_count() * sizeof(void *) + live.capacity() * sizeof(Chunk *);
+}
+
+int Plane::Threads()
+{
+    return pool->Threads();
+}
+
+int Plane::set_threads(int n)
+{
+    if (n < 1) {
+        return RET_ERROR;
+    }
+    if (!pool || pool->Threads() != n) {
+        delete pool;
+        pool = new WorkerPool(n);
+        bands.assign(n, Band());
+    }
+    return RET_OK;
+}
+
+Rule Plane::ActiveRule()
+{
+    return rule;
+}
+
+int Plane::set_rule(const Rule &r)
+{
+    if (r.born & 1) {
+        return RET_ERROR;
+    }
+    if (r != rule) {
+        rule = r;
+        for (Chunk *chunk : live) {
+            chunk->changed = true;
+        }
+    }
+    return RET_OK;
+}
+
+int Plane::initialize()
+{
+    for (Chunk *chunk : live) {
+        delete chunk;
+    }
+    live.clear();
+    live.shrink_to_fit();
+    chunks.clear();
+    active.clear();
+    phase = 0;
+    has_previous = false;
+    rounds = 0;
+    population = 0;
+    new_borns = new_deads = 0;
+    return RET_OK;
+}
+
+int Plane::load(Board *board)
+{
+    Rule r = board->ActiveRule();
+    if (r.born & 1) {
+        return RET_ERROR;
+    }
+    initialize();
+    rule = r;
+    const BitGrid &grid = board->current_grid();
+    int words = grid.Words();
+    uint64_t tail = grid.tail_mask();
+    for (int row = 0; row < grid.Height(); ++row) {
+        const uint64_t *src = grid.row(row);
+        for (int w = 0; w < words; ++w) {
+            uint64_t bits = (w == words - 1) ? src[w] & tail : src[w];
+            if (!bits) {
+                continue;
+            }
+            Chunk *chunk = find(row / CHUNK_SIZE, w);
+            if (!chunk) {
+                chunk = create(row / CHUNK_SIZE, w);
+            }
+            chunk->cells[phase][row % CHUNK_SIZE] = bits;
+            population += popcount64(bits);
+        }
+    }
+    rounds = board->Rounds();
+    return RET_OK;
+}
+
+// cells outside the board's rectangle are dropped
+int Plane::store(Board *board)
+{
+    if (rounds > INT_MAX) {
+        return RET_ERROR;
+    }
+    BitGrid grid(board->Width(), board->Height());
+    extract(grid, nullptr, 0, 0);
+    return board->replace(grid, (int)rounds);
+}
+
+void Plane::squares(std::vector<Square> &out) const
+{
+    out.clear();
+    for (const Chunk *chunk : live) {
+        if (is_empty(chunk->cells[phase])) {
+            continue;
+        }
+        Square s;
+        s.row = chunk->row;
+        s.column = chunk->column;
+        memcpy(s.cells, chunk->cells[phase], sizeof(s.cells));
+        out.push_back(s);
+    }
+}
+
+// squares out of range are dropped, the rule is kept
+int Plane::replace(const std::vector<Square> &in, long long generation)
+{
+    if (generation < 0) {
+        return RET_ERROR;
+    }
+    initialize();
+    for (const Square &s : in) {
+        if (!in_range(s.row) || !in_range(s.column)) {
+            continue;
+        }
+        Chunk *chunk = find(s.row, s.column);
+        if (!chunk) {
+            chunk = create(s.row, s.column);
+        }
+        for (int r = 0; r < CHUNK_SIZE; ++r) {
+            chunk->cells[phase][r] |= s.cells[r];
+        }
+    }
+    for (const Chunk *chunk : live) {
+        for (int r = 0; r < CHUNK_SIZE; ++r) {
+            population += popcount64(chunk->cells[phase][r]);
+        }
+    }
+    rounds = generation;
+    return RET_OK;
+}
+
+void Plane::extract(BitGrid &cur, BitGrid *prev, int64_t top, int64_t left) const
+{
+    cur.clear();
+    if (prev) {
+        prev->clear();
+    }
+    int words = cur.Words();
+    int64_t bottom = top + cur.Height();
+    int64_t right = left + cur.Width();
+    for (const Chunk *chunk : live) {
+        int64_t row = (int64_t)chunk->row * CHUNK_SIZE;
+        int64_t column = (int64_t)chunk->column * 64;
+        if (row >= bottom || row + CHUNK_SIZE <= top || column >= right || column + 64 <= left) {
+            continue;
+        }
+        int first = (int)std::max<int64_t>(0, top - row);
+        int last = (int)std::min<int64_t>(CHUNK_SIZE, bottom - row);
+        for (int r = first; r < last; ++r) {
+            int y = (int)(row + r - top);
+            put_word(cur.row(y), words, column - left, chunk->cells[phase][r]);
+            if (prev && has_previous) {
+                put_word(prev->row(y), words, column - left, chunk->cells[phase ^ 1][r]);
+            }
+        }
+    }
+    // nothing may be left past the last column
+    uint64_t tail = cur.tail_mask();
+    for (int y = 0; y < cur.Height(); ++y) {
+        cur.row(y)[words - 1] &= tail;
+        if (prev) {
+            prev->row(y)[words - 1] &= tail;
+        }
+    }
+}
+
+int Plane::evolve()
+{
+    // room for births, chunks created here are appended and need no growing
+    size_t count = live.size();
+    for (size_t i = 0; i < count; ++i) {
+        grow(live[i]);
+    }
+
+    // only chunks that changed, or touch one that did, can change now
+    for (Chunk *chunk : live) {
+        chunk->awake = false;
+    }
+    for (Chunk *chunk : live) {
+        if (!chunk->changed) {
+            continue;
+        }
+        chunk->awake = true;
+        for (int d = 0; d < 8; ++d) {
+            Chunk *n = find(chunk->row + AROUND_ROW[d], chunk->column + AROUND_COLUMN[d]);
+            if (n) {
+                n->awake = true;
+            }
+        }
+    }
+    active.clear();
+    for (Chunk *chunk : live) {
+        if (chunk->awake) {
+            active.push_back(chunk);
+        } else {
+            // the next generation of a quiet chunk is the current one
+            memcpy(chunk->cells[phase ^ 1], chunk->cells[phase], sizeof(chunk->cells[0]));
+            chunk->changed = false;
+        }
+    }
+
+    int bandCount = 1;
+    if (pool->Threads() > 1 && active.size() >= PLANE_PARALLEL_MIN_CHUNKS) {
+        // chunks only read their neighbours' current cells and write their own next ones
+        bandCount = pool->Threads();
+        size_t total = active.size();
+        pool->run([this, bandCount, total](int id) {
+            evolve_band(total * id / bandCount, total * (id + 1) / bandCount, bands[id]);
+        });
+    } else {
+        evolve_band(0, active.size(), bands[0]);
+    }
+    new_borns = new_deads = 0;
+    for (int i = 0; i < bandCount; ++i) {
+        new_borns += bands[i].borns;
+        new_deads += bands[i].deads;
+    }
+    population += new_borns - new_deads;
+    phase ^= 1;
+    has_previous = true;
+    rounds += 1;
+
+    // quiet chunks did not change, only the computed ones can have emptied
+    for (Chunk *chunk : active) {
+        if (is_empty(chunk->cells[phase]) && is_empty(chunk->cells[phase ^ 1]) && !needed(chunk)) {
+            release(chunk);
+        }
+    }
+    active.clear();
+    return RET_OK;
+}
+
+// the rule is looked up once per band, the kernel is compiled into the loop
+void Plane::evolve_band(size_t begin, size_t end, Band &band)
+{
+    switch (rule.kernel()) {
+    case Rule::CONWAY:
+        evolve_chunks(begin, end, band, ConwayKernel());
+        break;
+    case Rule::HIGHLIFE:
+        evolve_chunks(begin, end, band, HighLifeKernel());
+        break;
+    case Rule::DAY_AND_NIGHT:
+        evolve_chunks(begin, end, band, DayAndNightKernel());
+        break;
+    case Rule::SEEDS:
+        evolve_chunks(begin, end, band, SeedsKernel());
+        break;
+    default: {
+        TableKernel table = {rule.born, rule.survive};
+        evolve_chunks(begin, end, band, table);
+        break;
+    }
+    }
+}
+
+// Each chunk is computed from a copy of its rows with the neighbouring
+// words beside them and the neighbouring rows above and below, so the
+// kernel reads them as it reads the halo of a grid.
+template <class Kernel>
+void Plane::evolve_chunks(size_t begin, size_t end, Band &band, const Kernel &kernel)
+{
+    const int cur = phase, nxt = phase ^ 1;
+    long long borns = 0, deads = 0;
+    uint64_t rows[CHUNK_SIZE + 2][3];
+    for (size_t i = begin; i < end; ++i) {
+        Chunk *chunk = active[i];
+        const Chunk *around[8];
+        for (int d = 0; d < 8; ++d) {
+            around[d] = find(chunk->row + AROUND_ROW[d], chunk->column + AROUND_COLUMN[d]);
+        }
+        const uint64_t *self = chunk->cells[cur];
+        const uint64_t *west = around[W] ? around[W]->cells[cur] : nullptr;
+        const uint64_t *east = around[E] ? around[E]->cells[cur] : nullptr;
+        rows[0][0] = around[NW] ? around[NW]->cells[cur][CHUNK_SIZE - 1] : 0;
+        rows[0][1] = around[N] ? around[N]->cells[cur][CHUNK_SIZE - 1] : 0;
+        rows[0][2] = around[NE] ? around[NE]->cells[cur][CHUNK_SIZE - 1] : 0;
+        for (int r = 0; r < CHUNK_SIZE; ++r) {
+            rows[r + 1][0] = west ? west[r] : 0;
+            rows[r + 1][1] = self[r];
+            rows[r + 1][2] = east ? east[r] : 0;
+        }
+        rows[CHUNK_SIZE + 1][0] = around[SW] ? around[SW]->cells[cur][0] : 0;
+        rows[CHUNK_SIZE + 1][1] = around[S] ? around[S]->cells[cur][0] : 0;
+        rows[CHUNK_SIZE + 1][2] = around[SE] ? around[SE]->cells[cur][0] : 0;
+
+        uint64_t *dst = chunk->cells[nxt];
+        uint64_t any = 0;
+        for (int r = 0; r < CHUNK_SIZE; ++r) {
+            uint64_t next = evolve_word(&rows[r][1], &rows[r + 1][1], &rows[r + 2][1], kernel);
+            uint64_t diff = next ^ self[r];
+            borns += popcount64(diff & next);
+            deads += popcount64(diff & self[r]);
+            any |= diff;
+            dst[r] = next;
+        }
+        chunk->changed = (any != 0);
+    }
+    band.borns = borns;
+    band.deads = deads;
+}
+
+int Plane::flip(int64_t row, int64_t column)
+{
+    int64_t chunk_row = row >> 6;
+    int64_t chunk_column = column >> 6;
+    if (!in_range(chunk_row) || !in_range(chunk_column)) {
+        return RET_ERROR;
+    }
+    Chunk *chunk = find((int32_t)chunk_row, (int32_t)chunk_column);
+    if (!chunk) {
+        chunk = create((int32_t)chunk_row, (int32_t)chunk_column);
+    }
+    uint64_t bit = (uint64_t)1 << (column & 63);
+    uint64_t &word = chunk->cells[phase][row & (CHUNK_SIZE - 1)];
+    word ^= bit;
+    population += (word & bit) ? 1 : -1;
+    chunk->changed = true;
+    return RET_OK;
+}
+
+Board::CELL_STATE Plane::single_state(int64_t row, int64_t column) const
+{
+    int64_t chunk_row = row >> 6;
+    int64_t chunk_column = column >> 6;
+    if (!in_range(chunk_row) || !in_range(chunk_column)) {
+        return Board::STILL_NULL;
+    }
+    const Chunk *chunk = find((int32_t)chunk_row, (int32_t)chunk_column);
+    if (!chunk) {
+        return Board::STILL_NULL;
+    }
+    int now = (chunk->cells[phase][row & (CHUNK_SIZE - 1)] >> (column & 63)) & 1;
+    int before = has_previous && ((chunk->cells[phase ^ 1][row & (CHUNK_SIZE - 1)] >> (column & 63)) & 1);
+    if (before) {
+        return now ? Board::STILL_ALIVE : Board::NEW_DEAD;
+    } else {
+        return now ? Board::NEW_BORN : Board::STILL_NULL;
+    }
+}
+
+long long Plane::cell_amount()
+{
+    return population;
+}
+
+long long Plane::increment()
+{
+    return new_borns;
+}
+
+long long Plane::decrement()
+{
+    return new_deads;
+}
@@ -0,0 +1,108 @@
+#ifndef PLANE_H
+#define PLANE_H
+
+#define CHUNK_SIZE 64 // rows per chunk, a chunk is one word wide
+#define PLANE_PARALLEL_MIN_CHUNKS 64 // fewer active chunks are not worth waking the pool
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "board.h"
+
+// An unbounded plane stored as a hash map of 64x64 chunks.
+// A chunk is allocated when cells may be born in it, that is when a
+// neighbouring chunk has live cells on the edge they share, and freed once
+// it has been empty for two generations and nothing alive touches it, so
+// memory follows the live area rather than its bounding box. Chunks that
+// did not change, and have no neighbour that did, are not computed.
+class Plane
+{
+private:
+    struct Chunk {
+        int32_t row, column; // position in chunks, cell row = row * CHUNK_SIZE
+        uint64_t cells[2][CHUNK_SIZE]; // indexed by phase, current and previous
+        bool changed; // differs from the previous generation
+        bool awake; // may change in the coming generation
+        size_t slot; // position in the live list
+    };
+
+    // what each worker found, merged after the generation
+    struct Band {
+        long long borns, deads;
+    };
+
+    std::unordered_map<uint64_t, Chunk *> chunks;
+    std::vector<Chunk *> live;
+    std::vector<Chunk *> active;
+    std::vector<Band> bands;
+    WorkerPool *pool;
+    int phase;
+    bool has_previous;
+    long long rounds;
+    long long population;
+    long long new_borns, new_deads;
+    Rule rule;
+
+    static uint64_t key(int32_t row, int32_t column);
+    Chunk *find(int32_t row, int32_t column) const;
+    Chunk *create(int32_t row, int32_t column);
+    void release(Chunk *chunk);
+    int edges(const Chunk *chunk, int current) const;
+    void grow(Chunk *chunk);
+    bool needed(const Chunk *chunk) const;
+    void evolve_band(size_t begin, size_t end, Band &band);
+    template <class Kernel>
+    void evolve_chunks(size_t begin, size_t end, Band &band, const Kernel &kernel);
+
+public:
+    enum RETURN_VALUE {RET_ERROR = -1, RET_OK};
+
+    // a 64x64 square of cells, row and column count chunks
+    struct Square {
+        int32_t row, column;
+        uint64_t cells[CHUNK_SIZE];
+    };
+
+    Plane();
+    ~Plane();
+    Plane(const Plane &) = delete;
+    Plane &operator=(const Plane &) = delete;
+
+    // basic funcs
+    long long Rounds();
+    size_t Chunks();
+    size_t bytes();
+    int Threads();
+    int set_threads(int n);
+    Rule ActiveRule();
+    int set_rule(const Rule &r);
+    int initialize();
+
+    // board exchange, the board's upper left cell is the plane's origin;
+    // rules with B0 would fill the plane and are refused
+    int load(Board *board);
+    int store(Board *board);
+
+    // square exchange, the current cells of every chunk with any alive and
+    // the plane replaced by such squares at the given generation
+    void squares(std::vector<Square> &out) const;
+    int replace(const std::vector<Square> &in, long long generation);
+
+    // window access, copies the cells from row top and column left on
+    // into grids of the window's size
+    void extract(BitGrid &cur, BitGrid *prev, int64_t top, int64_t left) const;
+
+    // evolution operation
+    int evolve();
+
+    // content operation
+    int flip(int64_t row, int64_t column);
+    Board::CELL_STATE single_state(int64_t row, int64_t column) const;
+
+    // calculation operation
+    long long cell_amount();
+    long long increment();
+    long long decrement();
+};
+
+#endif // PLANE_H
@@ -1,5 +1,8 @@
 #include "player.h"
 #include <QDebug>
+#include <QThread>
+#include <algorithm>
+#include <climits>
 
 Player::Player(QWidget *parent)
     : QMainWindow(parent)
@@ -10,12 +13,26 @@ Player::Player(QWidget *parent)
     setWindowTitle("Life Game");
 
     // board and screen
-    board = new Board(ROWS, COLUMNS);
+    board = new Board(COLUMNS, ROWS);
+    board->set_threads(QThread::idealThreadCount());
+    speed = 1;
+    simulator = new Simulator(this);
+    simulator->setBoard(board);
+    simulator->setRate(speed);
+    hashlife = new HashLife;
+    plane = new Plane;
+    plane->set_threads(QThread::idealThreadCount());
+    unbounded = false;
+    windowTop = windowLeft = 0;
+    windowRows = windowColumns = windowLevel = 0;
     screen = new Screen(this);
-    connect(screen, SIGNAL(cell_flipped(int,int)), this, SLOT(on_screen_cell_flipped(int,int)));
+    connect(screen, SIGNAL(cell_flipped(qint64,qint64)), this, SLOT(on_screen_cell_flipped(qint64,qint64)));
     screen->setSize(size());
-    screen->setBoard(board);
-    screen->update();
+    sparkline = new Sparkline(screen);
+    sparkline->setSeries(&simulator->timeSeries());
+    sparkline->move((screen->width() - SPARKLINE_WIDTH) / 2, screen->height() - SPARKLINE_HEIGHT - 10);
+    shown = 0;
+    refresh();
 
     // user interface
     // new
@@ -29,10 +46,24 @@ Player::Player(QWidget *parent)
     playAction->setCheckable(true);
     nextAction = new QAction(QIcon(":/image/icons/chevron-right.png"), QString("next"), this);
     prevAction = new QAction(QIcon(":/image/icons/chevron-left.png"), QString("prev"), this);
+    skipAction = new QAction(QIcon(":/image/icons/calendar.png"), QString("skip ahead"), this);
     speedUpAction = new QAction(QIcon(":/image/icons/forward.png"), QString("speed up"), this);
     speedDownAction = new QAction(QIcon(":/image/icons/backward.png"), QString("speed down"), this);
     clearAction = new QAction(QIcon(":/image/icons/delete.png"), QString("clear"), this);
     reloadAction = new QAction(QIcon(":/image/icons/refresh.png"), QString("reload"), this);
+    openAction = new QAction(QIcon(":/image/icons/file.png"), QString("open"), this);
+    saveAction = new QAction(QIcon(":/image/icons/save.png"), QString("save"), this);
+    ruleAction = new QAction(QIcon(":/image/icons/star.png"), QString("rule"), this);
+    boundaryAction = new QAction(QIcon(":/image/icons/remove.png"), QString("boundary"), this);
+    planeAction = new QAction(QIcon(":/image/icons/check.png"), QString("unbounded"), this);
+    planeAction->setCheckable(true);
+    autoStopAction = new QAction(QString("stop on cycle"), this);
+    autoStopAction->setCheckable(true);
+    traceAction = new QAction(QString("trace"), this);
+    graphAction = new QAction(QString("graph"), this);
+    graphAction->setCheckable(true);
+    graphAction->setChecked(true);
+    exportAction = new QAction(QString("export series"), this);
     showLineAction = new QAction(QIcon(":/image/icons/grid.png"), QString("show line"), this);
     showLineAction->setCheckable(true);
     showLineAction->setChecked(true);
@@ -44,10 +75,21 @@ Player::Player(QWidget *parent)
     connect(playAction, SIGNAL(toggled(bool)), this, SLOT(on_playAction_toggled(bool)));
     connect(nextAction, SIGNAL(triggered(bool)), this, SLOT(on_nextAction_triggered()));
     connect(prevAction, SIGNAL(triggered(bool)), this, SLOT(on_prevAction_triggered()));
+    connect(skipAction, SIGNAL(triggered(bool)), this, SLOT(on_skipAction_triggered()));
     connect(speedUpAction, SIGNAL(triggered(bool)), this, SLOT(on_speedUpAction_triggered()));
     connect(speedDownAction, SIGNAL(triggered(bool)), this, SLOT(on_speedDownAction_triggered()));
     connect(clearAction, SIGNAL(triggered(bool)), this, SLOT(on_clearAction_triggered()));
     connect(reloadAction, SIGNAL(triggered(bool)), this, SLOT(on_reloadAction_triggered()));
+    connect(openAction, SIGNAL(triggered(bool)), this, SLOT(on_openAction_triggered()));
+    connect(saveAction, SIGNAL(triggered(bool)), this, SLOT(on_saveAction_triggered()));
+    connect(ruleAction, SIGNAL(triggered(bool)), this, SLOT(on_ruleAction_triggered()));
+    connect(boundaryAction, SIGNAL(triggered(bool)), this, SLOT(on_boundaryAction_triggered()));
+    connect(planeAction, SIGNAL(toggled(bool)), this, SLOT(on_planeAction_toggled(bool)));
+    connect(autoStopAction, SIGNAL(toggled(bool)), this, SLOT(on_autoStopAction_toggled(bool)));
+    connect(simulator, SIGNAL(settled()), this, SLOT(on_simulator_settled()));
+    connect(traceAction, SIGNAL(triggered(bool)), this, SLOT(on_traceAction_triggered()));
+    connect(graphAction, SIGNAL(toggled(bool)), this, SLOT(on_graphAction_toggled(bool)));
+    connect(exportAction, SIGNAL(triggered(bool)), this, SLOT(on_exportAction_triggered()));
     connect(showLineAction, SIGNAL(triggered(bool)), this, SLOT(on_showLineAction_triggered(bool)));
 
     // toolbar
@@ -65,36 +107,122 @@ Player::Player(QWidget *parent)
     toolBar->addSeparator();
     toolBar->addAction(nextAction);
     toolBar->addAction(prevAction);
+    toolBar->addAction(skipAction);
     toolBar->addSeparator();
     toolBar->addAction(clearAction);
     toolBar->addAction(reloadAction);
     toolBar->addSeparator();
+    toolBar->addAction(openAction);
+    toolBar->addAction(saveAction);
+    toolBar->addSeparator();
+    toolBar->addAction(ruleAction);
+    toolBar->addAction(boundaryAction);
+    toolBar->addAction(planeAction);
+    toolBar->addAction(autoStopAction);
+#ifdef LIFE_PROFILE
+    toolBar->addAction(traceAction);
+#endif
+    toolBar->addAction(graphAction);
+    toolBar->addAction(exportAction);
     toolBar->addAction(showLineAction);
 
     // timer and notifier
-    speed = 1;
     timer = new QTimer(this);
     connect(timer, SIGNAL(timeout()), this, SLOT(on_timer_timeout()));
+    timer->start(REFRESH_INTERVAL);
 }
 
 void Player::update()
 {
     screen->update();
+    sparkline->update();
     QMainWindow::update();
 }
 
-void Player::on_screen_cell_flipped(int r, int c)
+// stop the simulation so that the board may be touched from this thread
+void Player::pause()
 {
     if (playAction->isChecked())
         playAction->setChecked(false);
-    board->flip(r, c);
+}
+
+// show the board after it has been changed from this thread
+void Player::refresh()
+{
+    follow();
+    simulator->publish();
+    const Frame *frame = simulator->acquire();
+    shown = frame->serial;
+    screen->setFrame(frame);
+    screen->setRates(simulator->rate(), speed);
     update();
 }
 
+// Frames are captured around the view with a chunk of margin on every
+// side, aligned to chunks, at the level the zoom draws. A plane is captured
+// cell by cell, a view of it wider than MAX_WINDOW shows its middle.
+bool Player::follow()
+{
+    qint64 top, left;
+    int rows, columns;
+    screen->visibleCells(top, left, rows, columns);
+    int level = screen->visibleLevel();
+    int most = unbounded ? MAX_WINDOW - 2 * CHUNK_SIZE : INT_MAX - 4 * CHUNK_SIZE;
+    if (rows > most) {
+        top += (rows - most) / 2;
+        rows = most;
+    }
+    if (columns > most) {
+        left += (columns - most) / 2;
+        columns = most;
+    }
+    qint64 bottom = top + rows + CHUNK_SIZE;
+    qint64 right = left + columns + CHUNK_SIZE;
+    top -= CHUNK_SIZE;
+    left -= CHUNK_SIZE;
+    top -= ((top % CHUNK_SIZE) + CHUNK_SIZE) % CHUNK_SIZE;
+    left -= ((left % CHUNK_SIZE) + CHUNK_SIZE) % CHUNK_SIZE;
+    rows = (int)std::min<qint64>(bottom - top, most + 2 * CHUNK_SIZE);
+    columns = (int)std::min<qint64>(right - left, most + 2 * CHUNK_SIZE);
+    if (top == windowTop && left == windowLeft && rows == windowRows && columns == windowColumns &&
+        level == windowLevel) {
+        return false;
+    }
+    windowTop = top;
+    windowLeft = left;
+    windowRows = rows;
+    windowColumns = columns;
+    windowLevel = level;
+    simulator->setWindow(top, left, columns, rows, level);
+    return true;
+}
+
+void Player::on_screen_cell_flipped(qint64 r, qint64 c)
+{
+    pause();
+    if (unbounded) {
+        plane->flip(r, c);
+    } else if (r >= 0 && r < board->Height() && c >= 0 && c < board->Width()) {
+        board->flip((int)r, (int)c);
+    }
+    refresh();
+}
+
+// the simulation runs on its own thread, the timer only picks up the newest frame
 void Player::on_timer_timeout()
 {
-    board->evolve();
-    update();
+    // a paused board or plane is captured again when the view has moved
+    if (follow() && !playAction->isChecked()) {
+        refresh();
+        return;
+    }
+    const Frame *frame = simulator->acquire();
+    if (frame->serial != shown) {
+        shown = frame->serial;
+        screen->setFrame(frame);
+        screen->setRates(simulator->rate(), speed);
+        update();
+    }
 }
 
 void Player::on_moveAction_triggered()
@@ -122,57 +250,276 @@ void Player::on_zoomOutAction_triggered()
 void Player::on_playAction_toggled(bool checked)
 {
     if (checked) {
-        timer->start(1000 / speed);
+        simulator->play();
     } else {
-        timer->stop();
+        simulator->pause();
     }
 }
 
 void Player::on_nextAction_triggered()
 {
-    board->evolve();
-    update();
+    pause();
+    if (unbounded)
+        plane->evolve();
+    else
+        board->evolve();
+    refresh();
 }
 
 void Player::on_prevAction_triggered()
 {
+    pause();
     board->decline();
-    update();
+    refresh();
 }
 
-void Player::on_speedUpAction_triggered()
+// HashLife runs an unbounded plane, so on the board it only jumps while
+// nothing alive can reach the border, one cell per generation at most.
+// Other boards are advanced in one batch when the skip is short enough.
+// The plane always jumps. The history restarts at the new generation.
+void Player::on_skipAction_triggered()
 {
-    if (speed < 8)
-        speed += 1;
-    if (playAction->isChecked()) {
-        timer->start(1000 / speed);
+    pause();
+    bool ok = false;
+    int k = QInputDialog::getInt(this, "Skip ahead", "Skip 2^k generations, k:", 10, 0, 30, 1, &ok);
+    if (!ok)
+        return;
+    int64_t n = (int64_t)1 << k;
+    if (unbounded) {
+        if (hashlife->load(plane) != HashLife::RET_OK || hashlife->jump(n) != HashLife::RET_OK ||
+            hashlife->store(plane) != HashLife::RET_OK) {
+            QMessageBox::warning(this, "Skip ahead", "The jump failed, the plane is unchanged.");
+            return;
+        }
+        refresh();
+        return;
+    }
+    // the board counts generations in an int
+    if (board->Rounds() + n > INT_MAX) {
+        QMessageBox::warning(this, "Skip ahead", "The board cannot count past generation " +
+                             QString::number(INT_MAX) + ".");
+        return;
     }
+    bool inside = (hashlife->load(board) == HashLife::RET_OK);
+    int64_t top, left, bottom, right;
+    if (inside && hashlife->bounds(top, left, bottom, right)) {
+        inside = top - n >= 0 && left - n >= 0 && bottom + n < board->Height() && right + n < board->Width();
+    }
+    if (!inside) {
+        if (k > MAX_DIRECT_SKIP) {
+            QMessageBox::warning(this, "Skip ahead", "Boards with wrapping borders or B0, or patterns that may reach "
+                                 "the border, skip at most 2^" + QString::number(MAX_DIRECT_SKIP) + " generations.");
+            return;
+        }
+        board->evolve(1 << k);
+        refresh();
+        return;
+    }
+    if (hashlife->jump(n) != HashLife::RET_OK || hashlife->store(board) != HashLife::RET_OK) {
+        QMessageBox::warning(this, "Skip ahead", "The jump failed, the board is unchanged.");
+        return;
+    }
+    refresh();
+}
+
+// speeds double from 1 to MAX_SPEED and then run unlimited
+void Player::on_speedUpAction_triggered()
+{
+    if (speed != 0)
+        speed = (speed < MAX_SPEED) ? speed * 2 : 0;
+    simulator->setRate(speed);
+    screen->setRates(simulator->rate(), speed);
+    update();
 }
 
 void Player::on_speedDownAction_triggered()
 {
-    if (speed > 1)
-        speed -= 1;
-    if (playAction->isChecked()) {
-        timer->start(1000 / speed);
-    }
+    if (speed == 0)
+        speed = MAX_SPEED;
+    else if (speed > 1)
+        speed /= 2;
+    simulator->setRate(speed);
+    screen->setRates(simulator->rate(), speed);
+    update();
 }
 
 void Player::on_clearAction_triggered()
 {
-    if (playAction->isChecked())
-        playAction->setChecked(false);
-    board->empty();
-    update();
+    pause();
+    if (unbounded)
+        plane->initialize();
+    else
+        board->empty();
+    simulator->timeSeries().clear();
+    refresh();
 }
 
 void Player::on_reloadAction_triggered()
 {
-    if (playAction->isChecked())
-        playAction->setChecked(false);
-    unsigned seed = QInputDialog::getInt(this, "Seed", "Input the seed for generation.", 0, 0);
-    board->randomize(seed);
-    update();
+    pause();
+    bool ok = false;
+    unsigned seed = QInputDialog::getInt(this, "Seed", "Input the seed for generation.", 0, 0, INT_MAX, 1, &ok);
+    if (!ok)
+        return;
+    double density = QInputDialog::getDouble(this, "Density", "Chance of a cell being alive:", 0.5, 0, 1, 3, &ok);
+    if (!ok)
+        return;
+    board->randomize(seed, density);
+    simulator->timeSeries().clear();
+    refresh();
+}
+
+// checkpoints resume a run, anything else is read as a pattern
+void Player::on_openAction_triggered()
+{
+    pause();
+    QString path = QFileDialog::getOpenFileName(this, "Open", QString(),
+                                                "Patterns and checkpoints (*.rle *.cells *.txt *.ckpt);;All files (*)");
+    if (path.isEmpty())
+        return;
+    QByteArray name = QFile::encodeName(path);
+    int ret;
+    if (path.endsWith(".ckpt"))
+        ret = Checkpoint::load(board, name.constData());
+    else
+        ret = Pattern::load(board, name.constData());
+    // a file that cannot be read leaves the board and its series as they were
+    if (ret != Board::RET_OK)
+        QMessageBox::warning(this, "Open", "Cannot read " + path);
+    else
+        simulator->timeSeries().clear();
+    refresh();
+}
+
+void Player::on_saveAction_triggered()
+{
+    pause();
+    QString path = QFileDialog::getSaveFileName(this, "Save", QString(),
+                                                "RLE (*.rle);;Plain text (*.cells);;Checkpoint (*.ckpt)");
+    if (path.isEmpty())
+        return;
+    QByteArray name = QFile::encodeName(path);
+    int ret;
+    if (path.endsWith(".ckpt"))
+        ret = Checkpoint::save(board, name.constData(), true);
+    else
+        ret = Pattern::save(board, name.constData(), Pattern::format_of(name.constData()));
+    if (ret != Board::RET_OK)
+        QMessageBox::warning(this, "Save", "Cannot write " + path);
+}
+
+// any B/S rule may be typed in, the list holds the ones with fast kernels
+void Player::on_ruleAction_triggered()
+{
+    pause();
+    QStringList rules;
+    rules << "B3/S23 (Life)" << "B36/S23 (HighLife)" << "B3678/S34678 (Day & Night)" << "B2/S (Seeds)";
+    QString current = QString::fromStdString(board->ActiveRule().name());
+    int index = 0;
+    for (int i = 0; i < rules.size(); ++i) {
+        if (rules[i].startsWith(current + " "))
+            index = i;
+    }
+    bool ok = false;
+    QString text = QInputDialog::getItem(this, "Rule", "Rule in B/S notation:", rules, index, true, &ok);
+    if (!ok)
+        return;
+    Rule rule;
+    if (Rule::parse(text.section(' ', 0, 0).toLatin1().constData(), rule) != Board::RET_OK) {
+        QMessageBox::warning(this, "Rule", "Cannot read the rule " + text);
+        return;
+    }
+    board->set_rule(rule);
+    refresh();
+}
+
+void Player::on_boundaryAction_triggered()
+{
+    pause();
+    QStringList boundaries;
+    boundaries << "dead border" << "torus" << "mirror";
+    bool ok = false;
+    QString text = QInputDialog::getItem(this, "Boundary", "Beyond the edges:", boundaries, board->Boundary(), false, &ok);
+    if (!ok)
+        return;
+    board->set_boundary((Board::BOUNDARY)boundaries.indexOf(text));
+    refresh();
+}
+
+// The board is copied into the plane with its upper left cell at the
+// origin and copied back when leaving, cells outside its rectangle are lost.
+// Actions that only make sense for the board are off meanwhile.
+void Player::on_planeAction_toggled(bool checked)
+{
+    if (checked == unbounded)
+        return;
+    pause();
+    if (checked) {
+        if (plane->load(board) != Plane::RET_OK) {
+            QMessageBox::warning(this, "Unbounded", "Rules with B0 would fill the whole plane.");
+            planeAction->setChecked(false);
+            return;
+        }
+        windowRows = windowColumns = 0;
+        follow();
+        simulator->setPlane(plane);
+    } else {
+        if (plane->store(board) != Plane::RET_OK)
+            QMessageBox::warning(this, "Unbounded", "Too many generations to go back to the board.");
+        simulator->setPlane(nullptr);
+        plane->initialize();
+    }
+    unbounded = checked;
+    simulator->timeSeries().clear();
+    QAction *boardOnly[] = {prevAction, reloadAction, openAction, saveAction, ruleAction, boundaryAction};
+    for (QAction *action : boardOnly)
+        action->setEnabled(!unbounded);
+    refresh();
+}
+
+// playing stops once the board repeats, the period shows on the screen
+void Player::on_autoStopAction_toggled(bool checked)
+{
+    simulator->setAutoStop(checked);
+}
+
+void Player::on_simulator_settled()
+{
+    pause();
+    refresh();
+}
+
+// the stage timers of the last frames as a Chrome trace
+void Player::on_traceAction_triggered()
+{
+#ifdef LIFE_PROFILE
+    bool ok = false;
+    int frames = QInputDialog::getInt(this, "Trace", "Frames to write:", 120, 1, PROFILE_FRAMES, 1, &ok);
+    if (!ok)
+        return;
+    QString path = QFileDialog::getSaveFileName(this, "Trace", "trace.json", "Chrome trace (*.json)");
+    if (path.isEmpty())
+        return;
+    if (Profiler::instance().write_trace(QFile::encodeName(path).constData(), frames) != Profiler::RET_OK)
+        QMessageBox::warning(this, "Trace", "Cannot write " + path);
+#endif
+}
+
+void Player::on_graphAction_toggled(bool checked)
+{
+    sparkline->setVisible(checked);
+}
+
+// what the simulator recorded since the board was last replaced, the
+// newest SERIES_CAPACITY generations of it
+void Player::on_exportAction_triggered()
+{
+    pause();
+    QString path = QFileDialog::getSaveFileName(this, "Export series", "series.csv", "CSV (*.csv)");
+    if (path.isEmpty())
+        return;
+    if (simulator->timeSeries().write_csv(QFile::encodeName(path).constData()) != TimeSeries::RET_OK)
+        QMessageBox::warning(this, "Export series", "Cannot write " + path);
 }
 
 void Player::on_showLineAction_triggered(bool checked)
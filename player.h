@@ -7,12 +7,25 @@
 #define ROWS 20
 #define COLUMNS 20
 
+#define REFRESH_INTERVAL 16 // milliseconds between screen refreshes
+#define MAX_SPEED 1024 // fastest limited speed, beyond it the board runs unlimited
+#define MAX_DIRECT_SKIP 16 // largest k of a 2^k skip done generation by generation
+
 #include <QMainWindow>
 #include <QToolBar>
 #include <QAction>
 #include <QTimer>
 #include <QInputDialog>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QFile>
 #include "screen.h"
+#include "simulator.h"
+#include "hashlife.h"
+#include "plane.h"
+#include "pattern.h"
+#include "checkpoint.h"
+#include "sparkline.h"
 
 class Player : public QMainWindow
 {
@@ -21,7 +34,15 @@ class Player : public QMainWindow
 private:
     Board *board;
     Screen *screen;
-    int speed; // evolutions per second
+    Sparkline *sparkline;
+    Simulator *simulator;
+    HashLife *hashlife;
+    Plane *plane;
+    bool unbounded; // the plane is running instead of the board
+    qint64 windowTop, windowLeft; // part of the world the frames show
+    int windowRows, windowColumns, windowLevel;
+    int speed; // evolutions per second, 0 for unlimited
+    unsigned long long shown; // serial of the frame on screen
     QTimer *timer;
     QAction *moveAction;
     QAction *flipAction;
@@ -30,19 +51,32 @@ private:
     QAction *playAction;
     QAction *nextAction;
     QAction *prevAction;
+    QAction *skipAction;
     QAction *speedUpAction;
     QAction *speedDownAction;
     QAction *clearAction;
     QAction *reloadAction;
+    QAction *openAction;
+    QAction *saveAction;
+    QAction *ruleAction;
+    QAction *boundaryAction;
+    QAction *planeAction;
+    QAction *autoStopAction;
+    QAction *traceAction; // only in profiling builds
+    QAction *graphAction;
+    QAction *exportAction;
     QAction *showLineAction;
 
 
 public:
     Player(QWidget *parent = 0);
     void update();
+    void pause();
+    void refresh();
+    bool follow();
 
 private slots:
-    void on_screen_cell_flipped(int r, int c);
+    void on_screen_cell_flipped(qint64 r, qint64 c);
     void on_timer_timeout();
     void on_moveAction_triggered();
     void on_flipAction_triggered();
@@ -51,10 +85,21 @@ private slots:
     void on_playAction_toggled(bool checked);
     void on_nextAction_triggered();
     void on_prevAction_triggered();
+    void on_skipAction_triggered();
     void on_speedUpAction_triggered();
     void on_speedDownAction_triggered();
     void on_clearAction_triggered();
     void on_reloadAction_triggered();
+    void on_openAction_triggered();
+    void on_saveAction_triggered();
+    void on_ruleAction_triggered();
+    void on_boundaryAction_triggered();
+    void on_planeAction_toggled(bool checked);
+    void on_autoStopAction_toggled(bool checked);
+    void on_simulator_settled();
+    void on_traceAction_triggered();
+    void on_graphAction_toggled(bool checked);
+    void on_exportAction_triggered();
     void on_showLineAction_triggered(bool checked);
 };
 
@@ -0,0 +1,70 @@
+#include "pool.h"
+
+WorkerPool::WorkerPool(int threads)
+    : job(nullptr), generation(0), pending(0), quit(false)
+{
+    for (int id = 1; id < threads; ++id) {
+        workers.emplace_back(&WorkerPool::loop, this, id);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    start_cond.notify_all();
+    for (std::thread &t : workers) {
+        t.join();
+    }
+}
+
+int WorkerPool::Threads() const
+{
+    return (int)workers.size() + 1;
+}
+
+void WorkerPool::run(const std::function<void(int)> &f)
+{
+    if (workers.empty()) {
+        f(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &f;
+        pending = (int)workers.size();
+        generation += 1;
+    }
+    start_cond.notify_all();
+    f(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cond.wait(lock, [this] { return pending == 0; });
+    job = nullptr;
+}
+
+void WorkerPool::loop(int id)
+{
+    unsigned long long seen = 0;
+    for (;;) {
+        const std::function<void(int)> *f;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cond.wait(lock, [this, seen] { return quit || generation != seen; });
+            if (quit) {
+                return;
+            }
+            seen = generation;
+            f = job;
+        }
+        (*f)(id);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending -= 1;
+            if (pending == 0) {
+                done_cond.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads.
+// run() hands the same job to every worker and returns once all of them
+// have finished; the calling thread takes part as worker 0, so a pool of
+// one thread never switches threads at all.
+class WorkerPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start_cond, done_cond;
+    const std::function<void(int)> *job;
+    unsigned long long generation;
+    int pending;
+    bool quit;
+
+    void loop(int id);
+
+public:
+    explicit WorkerPool(int threads);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    int Threads() const;
+    void run(const std::function<void(int)> &f);
+};
+
+#endif // POOL_H
@@ -0,0 +1,52 @@
+#ifndef PRNG_H
+#define PRNG_H
+
+#define DENSITY_BITS 16 // precision of the chance of a cell being alive
+
+#include <cstdint>
+
+// Counter-based random words: every word is a pure function of the seed
+// and its position, so any row can be generated on its own, by any thread,
+// and the same seed gives the same board on every machine.
+
+// the SplitMix64 / MurmurHash3 finaliser
+inline uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline uint64_t random_word(uint64_t key, uint64_t counter)
+{
+    return mix64(key + counter * 0x9e3779b97f4a7c15ULL);
+}
+
+// 64 cells that are each alive with chance density / 2^DENSITY_BITS.
+// The fraction is built bit by bit from the lowest set one: a 1 bit ORs in
+// a fresh random word and a 0 bit ANDs one in, halving or raising the chance
+// accordingly, so a density of one half costs a single word.
+inline uint64_t random_cells(uint64_t key, uint64_t counter, uint32_t density)
+{
+    if (density >= (1u << DENSITY_BITS)) {
+        return ~(uint64_t)0;
+    }
+    if (density == 0) {
+        return 0;
+    }
+    uint64_t x = 0;
+    counter *= DENSITY_BITS;
+    for (int b = 0; b < DENSITY_BITS; ++b) {
+        if (!x && !((density >> b) & 1)) {
+            continue;
+        }
+        uint64_t r = random_word(key, counter + b);
+        x = ((density >> b) & 1) ? (x | r) : (x & r);
+    }
+    return x;
+}
+
+#endif // PRNG_H
@@ -0,0 +1,108 @@
+#include "profiler.h"
+
+#ifdef LIFE_PROFILE
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+Profiler::Profiler()
+    : events(PROFILE_EVENTS), recorded(0), frames(PROFILE_FRAMES), marked(0), threads(0)
+{
+    for (int s = 0; s < STAGES; ++s) {
+        samples[s].assign(PROFILE_SAMPLES, 0);
+        sampled[s] = 0;
+    }
+}
+
+Profiler &Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+int64_t Profiler::now()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+const char *Profiler::name(int stage)
+{
+    static const char *names[] = {"evolve", "capture", "render", "labels", "paint"};
+    return (0 <= stage && stage < STAGES) ? names[stage] : "?";
+}
+
+void Profiler::record(int stage, int64_t begin, int64_t end)
+{
+    // threads are numbered in the order they first record something
+    static thread_local int thread = -1;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (thread < 0) {
+        thread = threads++;
+    }
+    samples[stage][sampled[stage]++ % PROFILE_SAMPLES] = end - begin;
+    Event &e = events[recorded++ % PROFILE_EVENTS];
+    e.begin = begin;
+    e.end = end;
+    e.stage = stage;
+    e.thread = thread;
+}
+
+void Profiler::frame()
+{
+    int64_t t = now();
+    std::lock_guard<std::mutex> lock(mutex);
+    frames[marked++ % PROFILE_FRAMES] = t;
+}
+
+// p between 0 and 1 over the last PROFILE_SAMPLES durations, in milliseconds
+double Profiler::percentile(int stage, double p)
+{
+    std::vector<int64_t> v;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t n = std::min<size_t>(sampled[stage], PROFILE_SAMPLES);
+        v.assign(samples[stage].begin(), samples[stage].begin() + n);
+    }
+    if (v.empty()) {
+        return 0;
+    }
+    size_t k = std::min(v.size() - 1, (size_t)(p * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k] / 1e6;
+}
+
+// Writes the scopes of the last frames in the Chrome trace event format,
+// to be opened in chrome://tracing or Perfetto. Scopes that began before
+// the oldest frame kept are left out.
+int Profiler::write_trace(const char *path, int last_frames)
+{
+    std::vector<Event> kept;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t n = std::min<size_t>(marked, std::min(PROFILE_FRAMES, std::max(last_frames, 1)));
+        int64_t since = n ? frames[(marked - n) % PROFILE_FRAMES] : 0;
+        size_t first = recorded > PROFILE_EVENTS ? recorded - PROFILE_EVENTS : 0;
+        for (size_t i = first; i < recorded; ++i) {
+            const Event &e = events[i % PROFILE_EVENTS];
+            if (e.begin >= since) {
+                kept.push_back(e);
+            }
+        }
+    }
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        return RET_ERROR;
+    }
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < kept.size(); ++i) {
+        const Event &e = kept[i];
+        fprintf(out, "{\"name\":\"%s\",\"cat\":\"life\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                name(e.stage), e.thread, e.begin / 1e3, (e.end - e.begin) / 1e3, i + 1 < kept.size() ? "," : "");
+    }
+    fprintf(out, "]}\n");
+    return fclose(out) == 0 ? RET_OK : RET_ERROR;
+}
+
+#endif // LIFE_PROFILE
@@ -0,0 +1,84 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#define PROFILE_SAMPLES 256 // durations per stage the percentiles are taken over
+#define PROFILE_EVENTS 65536 // timed scopes kept for the trace
+#define PROFILE_FRAMES 1024 // frame starts kept for the trace
+
+// Stage timers for finding where a frame's time goes. Build with
+// CONFIG+=profile to define LIFE_PROFILE; without it the macros below
+// expand to nothing and no profiler code is compiled at all.
+//
+//   PROFILE_SCOPE(Profiler::EVOLVE);   times the rest of the enclosing block
+//   PROFILE_FRAME();                   marks the start of a screen frame
+
+#ifdef LIFE_PROFILE
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class Profiler
+{
+public:
+    enum RETURN_VALUE {RET_ERROR = -1, RET_OK};
+    enum STAGE {EVOLVE, CAPTURE, RENDER, LABELS, PAINT, STAGES};
+
+private:
+    struct Event {
+        int64_t begin, end; // nanoseconds since the profiler started
+        int stage;
+        int thread;
+    };
+
+    std::mutex mutex;
+    std::vector<int64_t> samples[STAGES];
+    size_t sampled[STAGES];
+    std::vector<Event> events;
+    size_t recorded;
+    std::vector<int64_t> frames;
+    size_t marked;
+    int threads;
+
+    Profiler();
+
+public:
+    static Profiler &instance();
+    static int64_t now();
+    static const char *name(int stage);
+
+    // recording, safe from any thread
+    void record(int stage, int64_t begin, int64_t end);
+    void frame();
+
+    // reporting
+    double percentile(int stage, double p);
+    int write_trace(const char *path, int last_frames);
+};
+
+class ProfileScope
+{
+private:
+    int stage;
+    int64_t begin;
+
+public:
+    explicit ProfileScope(int _stage) : stage(_stage), begin(Profiler::now()) {}
+    ~ProfileScope() { Profiler::instance().record(stage, begin, Profiler::now()); }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_JOIN(profile_scope_, __LINE__)(stage)
+#define PROFILE_FRAME() Profiler::instance().frame()
+
+#else
+
+#define PROFILE_SCOPE(stage) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+
+#endif // LIFE_PROFILE
+
+#endif // PROFILER_H
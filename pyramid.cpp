@@ -0,0 +1,146 @@
+#include "pyramid.h"
+#include <algorithm>
+
+Pyramid::Pyramid()
+    : width(0), height(0), tile_columns(0), any_stale(false), all_stale(false)
+{
+}
+
+// the coarsest level, a single block holds every cell
+int Pyramid::Top() const
+{
+    return PYRAMID_BASE + (int)levels.size() - 1;
+}
+
+int Pyramid::Columns(int l) const
+{
+    return columns[l - PYRAMID_BASE];
+}
+
+int Pyramid::Rows(int l) const
+{
+    return rows[l - PYRAMID_BASE];
+}
+
+void Pyramid::resize(int w, int h)
+{
+    width = w;
+    height = h;
+    levels.clear();
+    columns.clear();
+    rows.clear();
+    for (int l = PYRAMID_BASE; ; ++l) {
+        int size = 1 << l;
+        columns.push_back((w + size - 1) / size);
+        rows.push_back((h + size - 1) / size);
+        levels.push_back(std::vector<uint32_t>((size_t)columns.back() * rows.back(), 0));
+        if (columns.back() == 1 && rows.back() == 1) {
+            break;
+        }
+    }
+    tile_columns = (w + 63) / 64;
+    stale.assign((size_t)((h + 63) / 64) * tile_columns, 0);
+    touch_all();
+}
+
+void Pyramid::touch(int tile_row, int word)
+{
+    stale[(size_t)tile_row * tile_columns + word] = 1;
+    any_stale = true;
+}
+
+// tiles flagged the way Board tracks them, TILE_SIZE rows of one word
+void Pyramid::touch(const std::vector<unsigned char> &tiles)
+{
+    for (size_t i = 0; i < tiles.size() && i < stale.size(); ++i) {
+        if (tiles[i]) {
+            stale[i] = 1;
+            any_stale = true;
+        }
+    }
+}
+
+void Pyramid::touch_all()
+{
+    any_stale = all_stale = true;
+}
+
+void Pyramid::update(const BitGrid &grid)
+{
+    if (!any_stale) {
+        return;
+    }
+    int tile_rows = (height + 63) / 64;
+    for (int t = 0; t < tile_rows; ++t) {
+        for (int w = 0; w < tile_columns; ++w) {
+            unsigned char &s = stale[(size_t)t * tile_columns + w];
+            if (!all_stale && !s) {
+                continue;
+            }
+            s = 0;
+            count_tile(grid, t, w);
+            // the levels below a tile only depend on its own cells
+            for (int l = PYRAMID_BASE + 1; l <= std::min(PYRAMID_TILE, Top()); ++l) {
+                int blocks = 1 << (PYRAMID_TILE - l);
+                sum_blocks(l, t * blocks, (t + 1) * blocks, w * blocks, (w + 1) * blocks);
+            }
+        }
+    }
+    // above a tile there are few blocks, they are simply summed again
+    for (int l = PYRAMID_TILE + 1; l <= Top(); ++l) {
+        sum_blocks(l, 0, Rows(l), 0, Columns(l));
+    }
+    any_stale = all_stale = false;
+}
+
+// 8x8 counts of one 64x64 tile, the eight bytes of a word are counted side
+// by side and summed over eight rows, at most 64 fits in a byte
+void Pyramid::count_tile(const BitGrid &grid, int tile_row, int word)
+{
+    std::vector<uint32_t> &base = levels[0];
+    int cols = columns[0];
+    for (int g = 0; g < 8; ++g) {
+        int r0 = tile_row * 64 + g * 8;
+        if (r0 >= height) {
+            break;
+        }
+        uint64_t sum = 0;
+        for (int r = r0; r < r0 + 8 && r < height; ++r) {
+            uint64_t x = grid.row(r)[word];
+            x = x - ((x >> 1) & 0x5555555555555555ULL);
+            x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+            sum += (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        }
+        uint32_t *dst = &base[(size_t)(r0 / 8) * cols];
+        for (int b = 0; b < 8 && word * 8 + b < cols; ++b) {
+            dst[word * 8 + b] = (uint32_t)((sum >> (b * 8)) & 0xff);
+        }
+    }
+}
+
+// blocks of level l in the given range are the sums of their four quarters
+void Pyramid::sum_blocks(int l, int row_begin, int row_end, int column_begin, int column_end)
+{
+    row_end = std::min(row_end, Rows(l));
+    column_end = std::min(column_end, Columns(l));
+    for (int r = row_begin; r < row_end; ++r) {
+        uint32_t *dst = &levels[l - PYRAMID_BASE][(size_t)r * Columns(l)];
+        for (int c = column_begin; c < column_end; ++c) {
+            dst[c] = count(l - 1, r * 2, c * 2) + count(l - 1, r * 2, c * 2 + 1)
+                     + count(l - 1, r * 2 + 1, c * 2) + count(l - 1, r * 2 + 1, c * 2 + 1);
+        }
+    }
+}
+
+uint32_t Pyramid::count(int l, int row, int column) const
+{
+    if (row < 0 || row >= Rows(l) || column < 0 || column >= Columns(l)) {
+        return 0;
+    }
+    return levels[l - PYRAMID_BASE][(size_t)row * Columns(l) + column];
+}
+
+const uint32_t *Pyramid::row(int l, int r) const
+{
+    return &levels[l - PYRAMID_BASE][(size_t)r * Columns(l)];
+}
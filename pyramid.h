@@ -0,0 +1,48 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#define PYRAMID_BASE 3 // the finest level counts 8x8 blocks
+#define PYRAMID_TILE 6 // change tracking tiles are 64x64 cells
+
+#include <cstdint>
+#include <vector>
+#include "grid.h"
+
+// Alive counts of square blocks at every power of two from 8x8 up to one
+// block covering the whole grid, so a zoomed out view can be drawn from
+// the counts instead of the cells. Level l holds blocks of 2^l x 2^l cells.
+// Only 64x64 tiles marked with touch() are counted again by update().
+class Pyramid
+{
+private:
+    int width, height;
+    std::vector<std::vector<uint32_t> > levels; // levels[l - PYRAMID_BASE]
+    std::vector<int> columns, rows;
+    std::vector<unsigned char> stale;
+    int tile_columns;
+    bool any_stale, all_stale;
+
+    void count_tile(const BitGrid &grid, int tile_row, int word);
+    void sum_blocks(int l, int row_begin, int row_end, int column_begin, int column_end);
+
+public:
+    Pyramid();
+
+    // basic funcs
+    int Top() const;
+    int Columns(int l) const;
+    int Rows(int l) const;
+    void resize(int w, int h);
+
+    // change tracking
+    void touch(int tile_row, int word);
+    void touch(const std::vector<unsigned char> &tiles);
+    void touch_all();
+    void update(const BitGrid &grid);
+
+    // content operation
+    uint32_t count(int l, int row, int column) const;
+    const uint32_t *row(int l, int r) const;
+};
+
+#endif // PYRAMID_H
@@ -0,0 +1,112 @@
+#include "renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+Renderer::Renderer()
+    : width(0), height(0)
+{
+    palette[Board::NEW_BORN] = qRgb(180, 255, 200);
+    palette[Board::NEW_DEAD] = qRgb(255, 240, 240);
+    palette[Board::STILL_NULL] = qRgb(240, 240, 255);
+    palette[Board::STILL_ALIVE] = qRgb(100, 255, 120);
+    // from an empty block to a full one, sparse blocks are kept visible
+    for (int i = 0; i < 256; ++i) {
+        double t = (i == 0) ? 0 : 0.25 + 0.75 * i / 255.0;
+        shades[i] = qRgb(240 + (100 - 240) * t, 240 + (255 - 240) * t, 255 + (120 - 255) * t);
+    }
+}
+
+const QImage &Renderer::Image() const
+{
+    return image;
+}
+
+QRect Renderer::Area() const
+{
+    return area;
+}
+
+const QImage &Renderer::BlockImage() const
+{
+    return blockImage;
+}
+
+// cells must lie within the board
+void Renderer::render(const Frame *frame, QRect cells)
+{
+    QRect valid;
+    if (frame->Width() != width || frame->Height() != height) {
+        // another board, nothing drawn so far can be trusted
+        width = frame->Width();
+        height = frame->Height();
+        size_t words = (size_t)frame->cur.Words() * height;
+        shownCur.assign(words, 0);
+        shownPrev.assign(words, 0);
+        image = QImage();
+    }
+    if (cells != area || image.isNull()) {
+        QImage next(cells.size(), QImage::Format_RGB32);
+        if (!image.isNull()) {
+            valid = area.intersected(cells);
+        }
+        // move what is still visible into place
+        for (int r = valid.top(); r <= valid.bottom() && !valid.isEmpty(); ++r) {
+            memcpy(next.scanLine(r - cells.top()) + (valid.left() - cells.left()) * sizeof(QRgb),
+                   image.constScanLine(r - area.top()) + (valid.left() - area.left()) * sizeof(QRgb),
+                   valid.width() * sizeof(QRgb));
+        }
+        image = next;
+        area = cells;
+    } else {
+        valid = area;
+    }
+
+    for (int r = area.top(); r <= area.bottom(); ++r) {
+        bool rowValid = valid.top() <= r && r <= valid.bottom();
+        for (int c = area.left(); c <= area.right(); ) {
+            int w = c / 64;
+            int last = std::min(w * 64 + 63, area.right());
+            // cells of the word that are new in the image must be drawn anyway
+            bool force = !rowValid || c < valid.left() || last > valid.right();
+            renderSegment(frame, r, w, c, last, force);
+            c = last + 1;
+        }
+    }
+}
+
+// draws cells c0..c1 of word w in row r if they changed since they were last drawn
+void Renderer::renderSegment(const Frame *frame, int r, int w, int c0, int c1, bool force)
+{
+    uint64_t cur = frame->cur.row(r)[w];
+    uint64_t prev = frame->has_prev ? frame->prev.row(r)[w] : 0;
+    size_t index = (size_t)r * frame->cur.Words() + w;
+    if (!force && shownCur[index] == cur && shownPrev[index] == prev) {
+        return;
+    }
+    shownCur[index] = cur;
+    shownPrev[index] = prev;
+    static const int states[4] = {Board::STILL_NULL, Board::NEW_BORN, Board::NEW_DEAD, Board::STILL_ALIVE};
+    QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(r - area.top()));
+    for (int c = c0; c <= c1; ++c) {
+        int b = c % 64;
+        line[c - area.left()] = palette[states[(((prev >> b) & 1) << 1) | ((cur >> b) & 1)]];
+    }
+}
+
+// blocks must lie within the frame's level, the whole image is drawn again
+// but it is never larger than the screen
+void Renderer::renderBlocks(const Frame *frame, QRect blocks)
+{
+    if (blockImage.size() != blocks.size()) {
+        blockImage = QImage(blocks.size(), QImage::Format_RGB32);
+    }
+    double full = std::ldexp(1.0, 2 * frame->level);
+    for (int r = blocks.top(); r <= blocks.bottom(); ++r) {
+        const uint32_t *src = &frame->blocks[(size_t)r * frame->block_columns] + blocks.left();
+        QRgb *line = reinterpret_cast<QRgb *>(blockImage.scanLine(r - blocks.top()));
+        for (int c = 0; c < blocks.width(); ++c) {
+            line[c] = shades[src[c] ? 1 + (int)(std::sqrt(src[c] / full) * 254) : 0];
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <QImage>
+#include <QRect>
+#include <vector>
+#include "frame.h"
+
+// Keeps an image of the visible cells, one pixel per cell, that Screen
+// scales onto the canvas. Only cells whose words differ from the ones
+// last drawn are written again, and when the view moves the part that
+// is still visible is moved over instead of being drawn again.
+// Zoomed out below a pixel per cell, the blocks of the frame's level are
+// drawn instead, one pixel per block shaded by how many cells are alive.
+class Renderer
+{
+private:
+    QImage image;
+    QRect area; // cells covered by the image
+    int width, height;
+    std::vector<uint64_t> shownCur, shownPrev; // words as last drawn
+    QRgb palette[4];
+    QImage blockImage;
+    QRgb shades[256];
+
+    void renderSegment(const Frame *frame, int r, int w, int c0, int c1, bool force);
+
+public:
+    Renderer();
+    const QImage &Image() const;
+    QRect Area() const;
+    const QImage &BlockImage() const;
+    void render(const Frame *frame, QRect cells);
+    void renderBlocks(const Frame *frame, QRect blocks);
+};
+
+#endif // RENDERER_H
@@ -0,0 +1,106 @@
+#include "rule.h"
+#include "board.h"
+#include <cctype>
+
+Rule::Rule()
+    : born(1 << 3), survive((1 << 2) | (1 << 3))
+{
+}
+
+Rule::Rule(uint32_t _born, uint32_t _survive)
+    : born(_born), survive(_survive)
+{
+}
+
+bool Rule::operator==(const Rule &other) const
+{
+    return born == other.born && survive == other.survive;
+}
+
+bool Rule::operator!=(const Rule &other) const
+{
+    return !(*this == other);
+}
+
+static const char *read_counts(const char *p, uint32_t &mask)
+{
+    mask = 0;
+    while ('0' <= *p && *p <= '8') {
+        mask |= 1u << (*p - '0');
+        ++p;
+    }
+    return p;
+}
+
+int Rule::parse(const char *text, Rule &rule)
+{
+    const char *p = text;
+    while (isspace((unsigned char)*p)) {
+        ++p;
+    }
+    uint32_t b, s;
+    if (*p == 'B' || *p == 'b') {
+        p = read_counts(p + 1, b);
+        if (*p == '/') {
+            ++p;
+        }
+        if (*p != 'S' && *p != 's') {
+            return Board::RET_ERROR;
+        }
+        p = read_counts(p + 1, s);
+    } else {
+        p = read_counts(p, s);
+        if (*p != '/') {
+            return Board::RET_ERROR;
+        }
+        p = read_counts(p + 1, b);
+    }
+    while (isspace((unsigned char)*p)) {
+        ++p;
+    }
+    if (*p) {
+        return Board::RET_ERROR;
+    }
+    rule = Rule(b, s);
+    return Board::RET_OK;
+}
+
+std::string Rule::name() const
+{
+    std::string text = "B";
+    for (int n = 0; n <= 8; ++n) {
+        if ((born >> n) & 1) {
+            text += (char)('0' + n);
+        }
+    }
+    text += "/S";
+    for (int n = 0; n <= 8; ++n) {
+        if ((survive >> n) & 1) {
+            text += (char)('0' + n);
+        }
+    }
+    return text;
+}
+
+// the rules that have a kernel of their own, the rest use the table
+Rule::KERNEL Rule::kernel() const
+{
+    if (*this == Rule(1 << 3, (1 << 2) | (1 << 3))) {
+        return CONWAY;
+    }
+    if (*this == Rule((1 << 3) | (1 << 6), (1 << 2) | (1 << 3))) {
+        return HIGHLIFE;
+    }
+    if (*this == Rule((1 << 3) | (1 << 6) | (1 << 7) | (1 << 8), (1 << 3) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 8))) {
+        return DAY_AND_NIGHT;
+    }
+    if (*this == Rule(1 << 2, 0)) {
+        return SEEDS;
+    }
+    return TABLE;
+}
+
+int Rule::next(int alive, int count) const
+{
+    return ((alive ? survive : born) >> count) & 1;
+}
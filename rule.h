@@ -0,0 +1,29 @@
+#ifndef RULE_H
+#define RULE_H
+
+#include <cstdint>
+#include <string>
+
+// An outer-totalistic Life-like rule in B/S notation: bit n of born is set
+// when a dead cell with n live neighbours comes alive, bit n of survive
+// when a live one stays alive. "B3/S23" is Conway's Life.
+class Rule
+{
+public:
+    enum KERNEL {CONWAY, HIGHLIFE, DAY_AND_NIGHT, SEEDS, TABLE};
+
+    uint32_t born, survive;
+
+    Rule();
+    Rule(uint32_t _born, uint32_t _survive);
+    bool operator==(const Rule &other) const;
+    bool operator!=(const Rule &other) const;
+
+    // "B36/S23", "b36s23" or the older survive-first "23/36"
+    static int parse(const char *text, Rule &rule);
+    std::string name() const;
+    KERNEL kernel() const;
+    int next(int alive, int count) const;
+};
+
+#endif // RULE_H
@@ -1,5 +1,8 @@
 #include "screen.h"
 #include <QDebug>
+#include <algorithm>
+#include <climits>
+#include <cmath>
 
 Screen::Screen(QWidget *parent) : QWidget(parent)
 {
@@ -7,9 +10,14 @@ Screen::Screen(QWidget *parent) : QWidget(parent)
     viewInfoLabel = new QLabel(this);
     operation = MOVE;
     scale = 1;
-    pos = QPoint(0, 0);
-    board = nullptr;
+    pos = QPointF(0, 0);
+    frame = nullptr;
     showLines = true;
+    simulationRate = 0;
+    targetRate = 0;
+    renderFrames = 0;
+    renderRate = 0;
+    renderClock.start();
 
     dataInfoLabel->setAlignment(Qt::AlignBottom | Qt::AlignLeft);
     dataInfoLabel->setMargin(10);
@@ -17,9 +25,15 @@ Screen::Screen(QWidget *parent) : QWidget(parent)
     viewInfoLabel->setMargin(10);
 }
 
-void Screen::setBoard(Board *b)
+void Screen::setFrame(const Frame *f)
 {
-    board = b;
+    frame = f;
+}
+
+void Screen::setRates(double simulation, int target)
+{
+    simulationRate = simulation;
+    targetRate = target;
 }
 
 void Screen::setSize(QSize size)
@@ -54,82 +68,153 @@ void Screen::setShowLines(bool b)
     showLines = b;
 }
 
-void Screen::update()
+// the cells in view, in world coordinates
+void Screen::visibleCells(qint64 &top, qint64 &left, int &rows, int &columns)
+{
+    double u = UNIT * scale;
+    top = (qint64)floor(pos.y() / u);
+    left = (qint64)floor(pos.x() / u);
+    rows = (int)std::min<double>(ceil(height() / u) + 1, INT_MAX);
+    columns = (int)std::min<double>(ceil(width() / u) + 1, INT_MAX);
+}
+
+// the pyramid level drawn at this zoom, 0 while a cell is at least a pixel
+int Screen::visibleLevel()
+{
+    double u = UNIT * scale;
+    return u >= 1 ? 0 : std::max(PYRAMID_BASE, (int)ceil(log2(1 / u)));
+}
+
+// view coordinates clamped to the frame before they are turned into ints
+static int clampCell(double v, int limit)
+{
+    return (int)std::max(-1.0, std::min(v, (double)limit));
+}
+
+void Screen::drawCells()
 {
+    PROFILE_SCOPE(Profiler::RENDER);
     QPainter painter(&canvas);
-    int up = floor(pos.y() / (UNIT * scale));
-    int dn = ceil((pos.y() + height()) / (UNIT * scale));
-    int lt = floor(pos.x() / (UNIT * scale));
-    int rt = ceil((pos.x() + width()) / (UNIT * scale));
+    double u = UNIT * scale;
+    // the view relative to the frame's upper left cell
+    double ox = pos.x() - frame->left * u;
+    double oy = pos.y() - frame->top * u;
+    int up = clampCell(floor(oy / u), frame->Height());
+    int dn = clampCell(ceil((oy + height()) / u), frame->Height());
+    int lt = clampCell(floor(ox / u), frame->Width());
+    int rt = clampCell(ceil((ox + width()) / u), frame->Width());
 
     // clear canvas
     canvas.fill();
 
-    // fill blocks
-    for (int r = up; r <= dn; ++r) {
-        for (int c = lt; c <= rt; ++c) {
-            if (0 <= r && r < board->Height() && 0 <= c && c < board->Width()) {
-                QColor color(128, 128, 128, 128);
-                switch (board->single_state(r, c)) {
-                case Board::NEW_BORN:
-                    color = QColor(180, 255, 200, 255);
-                    break;
-                case Board::NEW_DEAD:
-                    color = QColor(255, 240, 240, 255);
-                    break;
-                case Board::STILL_ALIVE:
-                    color = QColor(100, 255, 120, 255);
-                    break;
-                case Board::STILL_NULL:
-                    color = QColor(240, 240, 255, 255);
-                    break;
-                }
-                painter.fillRect(c * UNIT * scale - pos.x(), r * UNIT * scale - pos.y(), UNIT * scale + 1, UNIT * scale + 1, color);
-            }
+    // fill blocks, a frame captured before the zoom changed is drawn scaled
+    if (frame->level == 0) {
+        QRect cells = QRect(lt, up, rt - lt + 1, dn - up + 1).intersected(QRect(0, 0, frame->Width(), frame->Height()));
+        if (!cells.isEmpty()) {
+            renderer.render(frame, cells);
+            painter.drawImage(QRectF(cells.left() * u - ox, cells.top() * u - oy, cells.width() * u, cells.height() * u),
+                              renderer.Image());
+        }
+    } else {
+        // more than one cell per pixel, the frame holds the smallest blocks
+        // that are at least a pixel wide
+        double b = u * (1 << frame->level);
+        int bl = clampCell(floor(ox / b), frame->block_columns);
+        int bt = clampCell(floor(oy / b), frame->block_rows);
+        QRect blocks = QRect(bl, bt, ceil(width() / b) + 2, ceil(height() / b) + 2)
+                       .intersected(QRect(0, 0, frame->block_columns, frame->block_rows));
+        if (!blocks.isEmpty()) {
+            renderer.renderBlocks(frame, blocks);
+            painter.drawImage(QRectF(blocks.left() * b - ox, blocks.top() * b - oy, blocks.width() * b, blocks.height() * b),
+                              renderer.BlockImage());
         }
     }
 
     // draw lines
-    if (showLines) {
+    if (showLines && u >= 4) {
         painter.setPen(QColor(128, 128, 255, 128));
-        for (int r = up; r <= dn; ++r) {
-            painter.drawLine(QPoint(0, r * UNIT * scale - pos.y()), QPoint(width(), r * UNIT * scale - pos.y()));
+        for (double y = floor(pos.y() / u) * u - pos.y(); y <= height(); y += u) {
+            painter.drawLine(QPointF(0, y), QPointF(width(), y));
         }
-        for (int c = lt; c <= rt; ++c) {
-            painter.drawLine(QPoint(c * UNIT * scale - pos.x(), 0), QPoint(c * UNIT * scale - pos.x(), height()));
+        for (double x = floor(pos.x() / u) * u - pos.x(); x <= width(); x += u) {
+            painter.drawLine(QPointF(x, 0), QPointF(x, height()));
         }
     }
+}
+
+void Screen::update()
+{
+    if (!frame) {
+        return;
+    }
+    PROFILE_FRAME();
+    drawCells();
+
+    // measure how often the screen is redrawn
+    renderFrames += 1;
+    if (renderClock.elapsed() >= 500) {
+        renderRate = renderFrames * 1000.0 / renderClock.restart();
+        renderFrames = 0;
+    }
 
     // update labels
+    updateInfo();
+
+    // update the whole widget
+    QWidget::update();
+}
+
+void Screen::updateInfo()
+{
+    PROFILE_SCOPE(Profiler::LABELS);
     QString text;
 
-    text.sprintf("Rounds:%d\n"
+    static const char *boundaries[] = {"dead", "torus", "mirror"};
+    QString cycle = frame->period ? QString("%1 since %2").arg(frame->period).arg(frame->period_start) : QString("none");
+    QString extent = frame->unbounded ? QString("unbounded, %1 chunks").arg((qulonglong)frame->chunks)
+                                    : QString("%1*%2").arg(frame->board_width).arg(frame->board_height);
+    text.sprintf("Rule:%s\n"
+                 "Boundary:%s\n"
+                 "Rounds:%lld\n"
                  "Seed:%x\n"
-                 "Size:%d*%d\n"
-                 "Amount:%d\n"
-                 "New Born:%d\n"
-                 "New Dead:%d",
-                 board->Rounds(), board->Seed(),
-                 board->Width(), board->Height(),
-                 board->cell_amount(),
-                 board->increment(), board->decrement());
+                 "Size:%s\n"
+                 "Amount:%lld\n"
+                 "New Born:%lld\n"
+                 "New Dead:%lld\n"
+                 "Period:%s",
+                 frame->rule.name().c_str(), frame->unbounded ? "none" : boundaries[frame->boundary],
+                 frame->rounds, frame->seed,
+                 extent.toLatin1().constData(),
+                 frame->amount,
+                 frame->borns, frame->deads,
+                 cycle.toLatin1().constData());
     dataInfoLabel->setText(text);
     dataInfoLabel->adjustSize();
     dataInfoLabel->setGeometry(0, size().height() - dataInfoLabel->height(), dataInfoLabel->width(), dataInfoLabel->height());
 
+    QString target = targetRate ? QString::number(targetRate) : QString("max");
     text.sprintf("Scale:%.2f\n"
-                 "X:%d, Y:%d",
-                 scale, -pos.x(), -pos.y());
+                 "X:%.0f, Y:%.0f\n"
+                 "Simulation:%.1f/s (target %s)\n"
+                 "Render:%.1f fps",
+                 scale, -pos.x(), -pos.y(),
+                 simulationRate, target.toLatin1().constData(),
+                 renderRate);
+#ifdef LIFE_PROFILE
+    for (int s = 0; s < Profiler::STAGES; ++s) {
+        text += QString("\n%1 p50 %2 p99 %3 ms").arg(Profiler::name(s))
+                .arg(Profiler::instance().percentile(s, 0.5), 0, 'f', 3)
+                .arg(Profiler::instance().percentile(s, 0.99), 0, 'f', 3);
+    }
+#endif
     viewInfoLabel->setText(text);
     viewInfoLabel->adjustSize();
     viewInfoLabel->setGeometry(0, 0, viewInfoLabel->width(), viewInfoLabel->height());
-
-    // update the whole widget
-    QWidget::update();
 }
 
 void Screen::paintEvent(QPaintEvent *e)
 {
+    PROFILE_SCOPE(Profiler::PAINT);
     QPainter painter(this);
     painter.drawPixmap(rect(), canvas);
     QWidget::paintEvent(e);
@@ -162,10 +247,8 @@ void Screen::mouseReleaseEvent(QMouseEvent *e)
     if (e->button() == Qt::LeftButton) {
         if ((e->pos() - pressPosition).manhattanLength() <= PRECISION) {
             // mouse click
-            int x = pos.x() + e->x();
-            int y = pos.y() + e->y();
-            int c = x / (UNIT * scale);
-            int r = y / (UNIT * scale);
+            qint64 c = (qint64)floor((pos.x() + e->x()) / (UNIT * scale));
+            qint64 r = (qint64)floor((pos.y() + e->y()) / (UNIT * scale));
             emit cell_flipped(r, c);
         }
     }
@@ -178,7 +261,7 @@ void Screen::wheelEvent(QWheelEvent *e)
     if (step > 0 && scale < 10) {
         f = 1.2;
     }
-    if (step < 0 && scale > 0.2){
+    if (step < 0 && scale > 0.001){
         f = 1 / 1.2;
     }
     setScale(f, e->pos());
@@ -11,7 +11,10 @@
 #include <QMouseEvent>
 #include <QPaintEvent>
 #include <QWheelEvent>
-#include "board.h"
+#include <QElapsedTimer>
+#include "frame.h"
+#include "renderer.h"
+#include "profiler.h"
 
 class Screen : public QWidget
 {
@@ -24,28 +27,38 @@ private:
     QLabel *dataInfoLabel;
     QLabel *viewInfoLabel;
     OPERATION operation;
-    Board *board;
+    const Frame *frame;
+    Renderer renderer;
     QPixmap canvas;
     double scale;
-    QPoint pos;
+    QPointF pos; // in pixels, wide enough to pan across the whole plane
     QPoint pressPosition;
     QPoint movePosition;
     bool showLines;
+    double simulationRate;
+    int targetRate;
+    QElapsedTimer renderClock;
+    int renderFrames;
+    double renderRate;
 
 signals:
-    void cell_flipped(int row, int column);
+    void cell_flipped(qint64 row, qint64 column);
 
 public:
     Screen(QWidget *parent = nullptr);
-    void setBoard(Board *b);
+    void setFrame(const Frame *f);
+    void setRates(double simulation, int target);
     void setSize(QSize size);
     void setOperation(OPERATION op);
     void setScale(double f);
     void setScale(double f, QPoint center);
     void setShowLines(bool b);
+    void visibleCells(qint64 &top, qint64 &left, int &rows, int &columns);
+    int visibleLevel();
     void update();
 
 private:
+    void drawCells();
     void updateInfo();
 
 protected:
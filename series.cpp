@@ -0,0 +1,100 @@
+#include "series.h"
+#include <algorithm>
+#include <cstdio>
+
+TimeSeries::TimeSeries(size_t capacity)
+    : ring(std::max<size_t>(capacity, 1) + 1), recorded(0)
+{
+}
+
+// one slot more than that, for the sample being written
+size_t TimeSeries::Capacity() const
+{
+    return ring.size() - 1;
+}
+
+unsigned long long TimeSeries::Recorded() const
+{
+    return recorded.load(std::memory_order_acquire);
+}
+
+// the only place besides the constructor that allocates
+int TimeSeries::set_capacity(size_t capacity)
+{
+    if (capacity < 1) {
+        return RET_ERROR;
+    }
+    if (capacity != Capacity()) {
+        std::vector<Slot>(capacity + 1).swap(ring);
+    }
+    clear();
+    return RET_OK;
+}
+
+void TimeSeries::clear()
+{
+    recorded.store(0, std::memory_order_release);
+}
+
+void TimeSeries::record(long long generation, long long population, long long borns, long long deads,
+                        long long nanoseconds)
+{
+    unsigned long long n = recorded.load(std::memory_order_relaxed);
+    // the count of the last sample becomes visible before this one's slot
+    // is overwritten, that is what a reader checks after copying
+    std::atomic_thread_fence(std::memory_order_release);
+    Slot &s = ring[n % ring.size()];
+    s.generation.store(generation, std::memory_order_relaxed);
+    s.population.store(population, std::memory_order_relaxed);
+    s.borns.store(borns, std::memory_order_relaxed);
+    s.deads.store(deads, std::memory_order_relaxed);
+    s.nanoseconds.store(nanoseconds, std::memory_order_relaxed);
+    recorded.store(n + 1, std::memory_order_release);
+}
+
+// Copies up to most of the newest samples into out and returns how many.
+// Sample i lives in slot i % size until sample i + size is written, so the
+// ones the writer may have reached meanwhile are dropped.
+size_t TimeSeries::snapshot(Sample *out, size_t most) const
+{
+    size_t size = ring.size();
+    unsigned long long end = recorded.load(std::memory_order_acquire);
+    unsigned long long count = std::min<unsigned long long>(std::min<unsigned long long>(end, size - 1), most);
+    unsigned long long begin = end - count;
+    for (unsigned long long i = begin; i < end; ++i) {
+        const Slot &s = ring[i % size];
+        Sample &d = out[i - begin];
+        d.generation = s.generation.load(std::memory_order_relaxed);
+        d.population = s.population.load(std::memory_order_relaxed);
+        d.borns = s.borns.load(std::memory_order_relaxed);
+        d.deads = s.deads.load(std::memory_order_relaxed);
+        d.nanoseconds = s.nanoseconds.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    unsigned long long now = recorded.load(std::memory_order_relaxed);
+    // the writer is at most filling sample now, which overwrites now - size
+    unsigned long long safe = (now + 1 > size) ? now + 1 - size : 0;
+    if (safe <= begin) {
+        return (size_t)count;
+    }
+    if (safe >= end) {
+        return 0;
+    }
+    std::copy(out + (safe - begin), out + count, out);
+    return (size_t)(end - safe);
+}
+
+int TimeSeries::write_csv(const char *path) const
+{
+    std::vector<Sample> samples(Capacity());
+    samples.resize(snapshot(samples.data(), samples.size()));
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        return RET_ERROR;
+    }
+    fprintf(file, "generation,population,borns,deads,nanoseconds\n");
+    for (const Sample &s : samples) {
+        fprintf(file, "%lld,%lld,%lld,%lld,%lld\n", s.generation, s.population, s.borns, s.deads, s.nanoseconds);
+    }
+    return fclose(file) == 0 ? RET_OK : RET_ERROR;
+}
@@ -0,0 +1,56 @@
+#ifndef SERIES_H
+#define SERIES_H
+
+#define SERIES_CAPACITY 65536 // generations kept by default, older ones are overwritten
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Population, births, deaths and step time of every generation run, kept
+// in a ring that is allocated once up front: recording is a few stores and
+// never allocates, so it can stay on for runs of any length and keeps the
+// newest Capacity() generations. One thread records while any other may
+// take a snapshot; a sample is published by the release store of the
+// count, and the reader drops samples the writer may have been overwriting
+// while they were copied.
+class TimeSeries
+{
+public:
+    enum RETURN_VALUE {RET_ERROR = -1, RET_OK};
+
+    struct Sample {
+        long long generation;
+        long long population;
+        long long borns, deads;
+        long long nanoseconds; // wall time of the step, a batch spread over its generations
+    };
+
+private:
+    struct Slot {
+        std::atomic<long long> generation, population, borns, deads, nanoseconds;
+    };
+
+    std::vector<Slot> ring;
+    std::atomic<unsigned long long> recorded;
+
+public:
+    explicit TimeSeries(size_t capacity = SERIES_CAPACITY);
+    TimeSeries(const TimeSeries &) = delete;
+    TimeSeries &operator=(const TimeSeries &) = delete;
+
+    // basic funcs, set_capacity() and clear() only while nothing records
+    size_t Capacity() const;
+    unsigned long long Recorded() const;
+    int set_capacity(size_t capacity);
+    void clear();
+
+    // the recording thread
+    void record(long long generation, long long population, long long borns, long long deads, long long nanoseconds);
+
+    // any thread, the newest samples oldest first
+    size_t snapshot(Sample *out, size_t most) const;
+    int write_csv(const char *path) const;
+};
+
+#endif // SERIES_H
@@ -0,0 +1,87 @@
+#include "simd.h"
+#include <atomic>
+#include <cstdlib>
+
+static int detect()
+{
+#ifdef LIFE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return Simd::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return Simd::AVX2;
+    }
+#endif
+    return Simd::SCALAR;
+}
+
+// LIFE_SIMD=scalar|avx2|avx512 in the environment caps the level at startup
+static int initial()
+{
+    int level = Simd::Supported();
+    const char *cap = getenv("LIFE_SIMD");
+    if (cap) {
+        for (int l = Simd::SCALAR; l <= Simd::AVX512; ++l) {
+            if (!strcmp(cap, Simd::name(l)) && l < level) {
+                level = l;
+            }
+        }
+    }
+    return level;
+}
+
+static std::atomic<int> &level_flag()
+{
+    static std::atomic<int> level(initial());
+    return level;
+}
+
+static std::atomic<bool> cross_check(false);
+static std::atomic<long long> mismatches(0);
+
+int Simd::Supported()
+{
+    static const int supported = detect();
+    return supported;
+}
+
+int Simd::Level()
+{
+    return level_flag().load(std::memory_order_relaxed);
+}
+
+int Simd::set_level(int level)
+{
+    if (level < SCALAR || level > Supported()) {
+        return RET_ERROR;
+    }
+    level_flag() = level;
+    return RET_OK;
+}
+
+const char *Simd::name(int level)
+{
+    static const char *names[] = {"scalar", "avx2", "avx512"};
+    return (SCALAR <= level && level <= AVX512) ? names[level] : "?";
+}
+
+bool Simd::CrossCheck()
+{
+    return cross_check.load(std::memory_order_relaxed);
+}
+
+void Simd::set_cross_check(bool on)
+{
+    cross_check = on;
+}
+
+long long Simd::Mismatches()
+{
+    return mismatches;
+}
+
+void Simd::mismatch(int count)
+{
+    mismatches += count;
+}
@@ -0,0 +1,118 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstdint>
+#include <cstring>
+#include "kernel.h"
+
+// Vector paths need the GCC/Clang vector extensions and target attributes,
+// other compilers always take the scalar loop.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define LIFE_SIMD
+#endif
+
+// Runs of words evolved 4 at a time with AVX2 or 8 at a time with AVX-512.
+// The instruction set is picked once from CPUID and may be lowered by
+// hand; every level computes exactly what the scalar loop computes, and
+// with the cross check on each vector result is compared against it.
+class Simd
+{
+public:
+    enum RETURN_VALUE {RET_ERROR = -1, RET_OK};
+    enum LEVEL {SCALAR, AVX2, AVX512};
+
+    static int Supported();
+    static int Level();
+    static int set_level(int level);
+    static const char *name(int level);
+
+    // test mode, mismatches are counted and the scalar result is kept
+    static bool CrossCheck();
+    static void set_cross_check(bool on);
+    static long long Mismatches();
+    static void mismatch(int count);
+};
+
+#ifdef LIFE_SIMD
+
+typedef uint64_t simd_u64x4 __attribute__((vector_size(32)));
+typedef uint64_t simd_u64x8 __attribute__((vector_size(64)));
+
+template <class V>
+inline V simd_load(const uint64_t *p)
+{
+    V v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// words [0, returned) of out are done, the rest is left to the caller
+template <class V, class Kernel>
+inline int simd_run(const uint64_t *up, const uint64_t *mid, const uint64_t *down, uint64_t *out, int n,
+                    const Kernel &kernel)
+{
+    const int lanes = sizeof(V) / sizeof(uint64_t);
+    int w = 0;
+    for (; w + lanes <= n; w += lanes) {
+        V s0, s1, s2, s3;
+        V m = simd_load<V>(mid + w);
+        neighbour_planes(simd_load<V>(up + w - 1), simd_load<V>(up + w), simd_load<V>(up + w + 1),
+                         simd_load<V>(mid + w - 1), m, simd_load<V>(mid + w + 1),
+                         simd_load<V>(down + w - 1), simd_load<V>(down + w), simd_load<V>(down + w + 1),
+                         s0, s1, s2, s3);
+        V next = kernel(s0, s1, s2, s3, m);
+        memcpy(out + w, &next, sizeof(next));
+    }
+    return w;
+}
+
+template <class Kernel>
+__attribute__((target("avx2"))) int simd_run_avx2(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                                                  uint64_t *out, int n, const Kernel &kernel)
+{
+    return simd_run<simd_u64x4>(up, mid, down, out, n, kernel);
+}
+
+template <class Kernel>
+__attribute__((target("avx512f"))) int simd_run_avx512(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                                                       uint64_t *out, int n, const Kernel &kernel)
+{
+    return simd_run<simd_u64x8>(up, mid, down, out, n, kernel);
+}
+
+#endif // LIFE_SIMD
+
+// out[i] becomes the next generation of mid[i] for i < n. Words [-1] and
+// [n] of up, mid and down must be readable.
+template <class Kernel>
+inline void evolve_run(const uint64_t *up, const uint64_t *mid, const uint64_t *down, uint64_t *out, int n,
+                       const Kernel &kernel)
+{
+    int done = 0;
+#ifdef LIFE_SIMD
+    int level = Simd::Level();
+    if (level == Simd::AVX512) {
+        done = simd_run_avx512(up, mid, down, out, n, kernel);
+    } else if (level == Simd::AVX2) {
+        done = simd_run_avx2(up, mid, down, out, n, kernel);
+    }
+    if (done && Simd::CrossCheck()) {
+        int wrong = 0;
+        for (int w = 0; w < done; ++w) {
+            uint64_t reference = evolve_word(up + w, mid + w, down + w, kernel);
+            if (out[w] != reference) {
+                out[w] = reference;
+                wrong += 1;
+            }
+        }
+        if (wrong) {
+            Simd::mismatch(wrong);
+        }
+    }
+#endif
+    for (int w = done; w < n; ++w) {
+        out[w] = evolve_word(up + w, mid + w, down + w, kernel);
+    }
+}
+
+#endif // SIMD_H
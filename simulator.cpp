@@ -0,0 +1,164 @@
+#include "simulator.h"
+#include <QElapsedTimer>
+
+Simulator::Simulator(QObject *parent)
+    : QThread(parent), board(nullptr), plane(nullptr), middle(1), front(0), back(2), serial(0),
+      running(false), target(1), measured(0), autoStop(false),
+      windowTop(0), windowLeft(0), windowWidth(CHUNK_SIZE), windowHeight(CHUNK_SIZE), windowLevel(0)
+{
+}
+
+Simulator::~Simulator()
+{
+    pause();
+}
+
+void Simulator::setBoard(Board *b)
+{
+    board = b;
+}
+
+// null goes back to the board, only while paused
+void Simulator::setPlane(Plane *p)
+{
+    plane = p;
+}
+
+// the part of the board or plane that goes into the next frames, a plane
+// is captured cell by cell and never more than MAX_WINDOW of it
+void Simulator::setWindow(int64_t top, int64_t left, int w, int h, int level)
+{
+    std::lock_guard<std::mutex> lock(windowMutex);
+    windowTop = top;
+    windowLeft = left;
+    windowWidth = qMax(1, w);
+    windowHeight = qMax(1, h);
+    windowLevel = level;
+}
+
+void Simulator::setAutoStop(bool b)
+{
+    autoStop = b;
+}
+
+// 0 means as fast as possible
+void Simulator::setRate(int evolutions_per_second)
+{
+    target = evolutions_per_second;
+}
+
+double Simulator::rate()
+{
+    return measured;
+}
+
+void Simulator::play()
+{
+    if (!isRunning()) {
+        running = true;
+        start();
+    }
+}
+
+void Simulator::pause()
+{
+    running = false;
+    wait();
+}
+
+// only one thread may publish at a time: the worker while it is running,
+// the GUI thread while it is paused
+void Simulator::publish()
+{
+    PROFILE_SCOPE(Profiler::CAPTURE);
+    int64_t top, left;
+    int w, h, level;
+    {
+        std::lock_guard<std::mutex> lock(windowMutex);
+        top = windowTop;
+        left = windowLeft;
+        w = windowWidth;
+        h = windowHeight;
+        level = windowLevel;
+    }
+    if (plane) {
+        frames[back].capture(plane, ++serial, top, left, qMin(w, MAX_WINDOW), qMin(h, MAX_WINDOW), level);
+    } else {
+        frames[back].capture(board, ++serial, top, left, w, h, level);
+    }
+    back = middle.exchange(back | FRESH) & ~FRESH;
+}
+
+TimeSeries &Simulator::timeSeries()
+{
+    return series;
+}
+
+const Frame *Simulator::acquire()
+{
+    if (middle.load() & FRESH) {
+        front = middle.exchange(front) & ~FRESH;
+    }
+    return &frames[front];
+}
+
+void Simulator::run()
+{
+    QElapsedTimer clock;
+    clock.start();
+    qint64 deadline = 0;
+    qint64 window = 0;
+    int generations = 0;
+    int batch = 1;
+    while (running) {
+        qint64 now = clock.nsecsElapsed();
+        int rate = target;
+        if (rate > 0) {
+            if (now < deadline) {
+                // sleep in short slices so that pause() stays responsive
+                QThread::usleep(qMin<qint64>(10000, (deadline - now) / 1000));
+                continue;
+            }
+            deadline = qMax(deadline, now - 1000000000LL / rate) + 1000000000LL / rate;
+        }
+        // cycles are only seen one generation at a time
+        int n = (rate == 0 && !plane && !autoStop) ? batch : 1;
+        {
+            PROFILE_SCOPE(Profiler::EVOLVE);
+            if (plane) {
+                plane->evolve();
+            } else {
+                board->evolve(n);
+            }
+        }
+        generations += n;
+        qint64 took = clock.nsecsElapsed() - now;
+        if (plane) {
+            series.record(plane->Rounds(), plane->cell_amount(), plane->increment(), plane->decrement(), took);
+        } else {
+            series.record(board->Rounds(), board->cell_amount(), board->increment(), board->decrement(), took / n);
+        }
+        if (took < BATCH_NANOSECONDS / 2 && batch < MAX_BATCH) {
+            batch *= 2;
+        } else if (took > BATCH_NANOSECONDS && batch > 1) {
+            batch /= 2;
+        }
+        if (autoStop && !plane && board->Period()) {
+            running = false;
+            emit settled();
+            break;
+        }
+        // the reader took the last frame, give it a new one
+        if (!(middle.load() & FRESH)) {
+            publish();
+        }
+        now = clock.nsecsElapsed();
+        if (now - window >= 250000000LL) {
+            measured = generations * 1e9 / (now - window);
+            window = now;
+            generations = 0;
+        }
+    }
+    measured = 0;
+    publish();
+}
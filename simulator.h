@@ -0,0 +1,71 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <QThread>
+#include <atomic>
+#include <mutex>
+#include "frame.h"
+#include "profiler.h"
+#include "series.h"
+
+#define MAX_WINDOW 8192 // widest and tallest part of a plane captured per frame
+#define MAX_BATCH 4096 // most generations per call when running unlimited
+#define BATCH_NANOSECONDS 8000000 // a batch should take about half a frame
+
+// Runs Board::evolve() on its own thread and hands finished generations to
+// the GUI through a lock-free triple buffer: the writer fills the back
+// frame and swaps it into the middle slot, the reader swaps the middle slot
+// with its front frame whenever a fresh one is waiting. Neither side ever
+// blocks the other, and the GUI always draws the newest complete frame.
+// With a plane set it runs Plane::evolve() instead. Frames show the window
+// the GUI last asked for, at the pyramid level it asked for. Unlimited runs advance the board in
+// batches that grow until one takes about half a frame, the frames only
+// show every so many generations anyway. With auto stop on, a board that has
+// started to repeat stops the thread and settled() is emitted. Every call
+// of evolve is recorded in the time series, so a batch is one sample; the
+// GUI may read it at any time and clear it only while paused.
+class Simulator : public QThread
+{
+    Q_OBJECT
+
+private:
+    enum {FRESH = 4};
+
+    Board *board;
+    Plane *plane;
+    Frame frames[3];
+    std::atomic<int> middle;
+    int front, back;
+    unsigned long long serial;
+    std::atomic<bool> running;
+    std::atomic<int> target;
+    std::atomic<double> measured;
+    std::atomic<bool> autoStop;
+    std::mutex windowMutex;
+    int64_t windowTop, windowLeft;
+    int windowWidth, windowHeight, windowLevel;
+    TimeSeries series;
+
+protected:
+    void run() override;
+
+public:
+    Simulator(QObject *parent = nullptr);
+    ~Simulator();
+    void setBoard(Board *b);
+    void setPlane(Plane *p);
+    void setWindow(int64_t top, int64_t left, int w, int h, int level);
+    void setRate(int evolutions_per_second);
+    void setAutoStop(bool b);
+    double rate();
+    void play();
+    void pause();
+    void publish();
+    const Frame *acquire();
+    TimeSeries &timeSeries();
+
+signals:
+    void settled();
+};
+
+#endif // SIMULATOR_H
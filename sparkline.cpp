@@ -0,0 +1,64 @@
+#include "sparkline.h"
+#include <algorithm>
+
+Sparkline::Sparkline(QWidget *parent) : QWidget(parent)
+{
+    series = nullptr;
+    samples.resize(SPARKLINE_SAMPLES);
+    points.resize(SPARKLINE_SAMPLES + 2);
+    setFixedSize(SPARKLINE_WIDTH, SPARKLINE_HEIGHT);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+}
+
+void Sparkline::setSeries(const TimeSeries *s)
+{
+    series = s;
+}
+
+void Sparkline::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(255, 255, 255, 200));
+    painter.setPen(QColor(128, 128, 128));
+    painter.drawRect(rect().adjusted(0, 0, -1, -1));
+    int n = series ? (int)series->snapshot(samples.data(), samples.size()) : 0;
+    if (n < 2) {
+        return;
+    }
+    long long high = 1, change = 1;
+    for (int i = 0; i < n; ++i) {
+        high = std::max(high, samples[i].population);
+        change = std::max(change, std::max(samples[i].borns, samples[i].deads));
+    }
+    double w = width() - 2, h = height() - 2;
+    double dx = w / (SPARKLINE_SAMPLES - 1);
+    double x0 = w - (n - 1) * dx + 1; // the newest sample is at the right edge
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    // population, as a filled area
+    for (int i = 0; i < n; ++i) {
+        points[i] = QPointF(x0 + i * dx, 1 + h - h * samples[i].population / high);
+    }
+    points[n] = QPointF(x0 + (n - 1) * dx, 1 + h);
+    points[n + 1] = QPointF(x0, 1 + h);
+    painter.setPen(QColor(64, 64, 192));
+    painter.setBrush(QColor(128, 128, 255, 96));
+    painter.drawPolygon(points.data(), n + 2);
+
+    // births and deaths
+    for (int i = 0; i < n; ++i) {
+        points[i] = QPointF(x0 + i * dx, 1 + h - h * samples[i].borns / change);
+    }
+    painter.setPen(QColor(0, 160, 0));
+    painter.drawPolyline(points.data(), n);
+    for (int i = 0; i < n; ++i) {
+        points[i] = QPointF(x0 + i * dx, 1 + h - h * samples[i].deads / change);
+    }
+    painter.setPen(QColor(200, 0, 0));
+    painter.drawPolyline(points.data(), n);
+
+    painter.setPen(QColor(0, 0, 0));
+    const TimeSeries::Sample &last = samples[n - 1];
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignTop | Qt::AlignLeft,
+                     QString("population %1  +%2  -%3").arg(last.population).arg(last.borns).arg(last.deads));
+}
@@ -0,0 +1,34 @@
+#ifndef SPARKLINE_H
+#define SPARKLINE_H
+
+#define SPARKLINE_WIDTH 360
+#define SPARKLINE_HEIGHT 90
+#define SPARKLINE_SAMPLES 360 // newest samples drawn, one per pixel column
+
+#include <QWidget>
+#include <QPainter>
+#include <QPaintEvent>
+#include <vector>
+#include "series.h"
+
+// A small live graph of the newest samples of a time series: population
+// filled in, births and deaths as lines on a scale of their own. The
+// sample and point buffers are sized once, a repaint only snapshots into them.
+class Sparkline : public QWidget
+{
+    Q_OBJECT
+
+private:
+    const TimeSeries *series;
+    std::vector<TimeSeries::Sample> samples;
+    std::vector<QPointF> points;
+
+public:
+    Sparkline(QWidget *parent = nullptr);
+    void setSeries(const TimeSeries *s);
+
+protected:
+    void paintEvent(QPaintEvent *);
+};
+
+#endif // SPARKLINE_H